@@ -8,6 +8,7 @@
 #include <string>
 #include <cassert>
 #include <mpi.h>
+#include <omp.h>
 #include "graph-base.h"
 #include "graph-utils.h"
 
@@ -35,7 +36,10 @@ void runFloydWarshallParallel(Graph* graph, int numProcesses, int myRank) {
 
         MPI_Bcast(graph->extraRow, m, MPI_INT, broadcastRank, MPI_COMM_WORLD);
 
-        for (int localRow = 0, globalRow = graph->firstRowIdxIncl; globalRow < graph->lastRowIdxExcl; ++localRow, ++globalRow) {
+        int numLocalRows = graph->lastRowIdxExcl - graph->firstRowIdxIncl;
+
+#pragma omp parallel for schedule(static)
+        for (int localRow = 0; localRow < numLocalRows; ++localRow) {
             for (int j = 0; j < m; ++j) {
                 int pathSum = graph->data[localRow][k] + graph->extraRow[j];
 
@@ -53,11 +57,23 @@ int main(int argc, char *argv[]) {
     int numProcesses = 0;
     int myRank = 0;
     int showResults = 0;
+    int threadSupport = 0;
 
-    MPI_Init(&argc, &argv);
+    /*
+     * Hybrid mode: run one rank per node (or socket) with OMP_NUM_THREADS
+     * threads relaxing its rows; MPI calls stay on the master thread.
+     */
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threadSupport);
     MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
     MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
 
+    if (threadSupport < MPI_THREAD_FUNNELED) {
+        if (myRank == 0) {
+            std::cerr << "MPI_THREAD_FUNNELED is not supported, using 1 thread." << std::endl;
+        }
+        omp_set_num_threads(1);
+    }
+
 #ifdef USE_RANDOM_GRAPH
 #ifdef USE_RANDOM_SEED
     srand(USE_RANDOM_SEED);
@@ -87,8 +103,8 @@ int main(int argc, char *argv[]) {
     }
 
     if (myRank == 0) {
-        std::cerr << "Running the Floyd-Warshall algorithm for a graph with " << numVertices << " vertices."
-                  << std::endl;
+        std::cerr << "Running the Floyd-Warshall algorithm for a graph with " << numVertices << " vertices on "
+                  << numProcesses << " process(es) x " << omp_get_max_threads() << " thread(s)." << std::endl;
     }
 
     auto graph = createAndDistributeGraph(numVertices, numProcesses, myRank);
@@ -47,6 +47,8 @@ bool InputOptions::isVerbose() { return this->verbose; }
 
 int InputOptions::getErrorCode() { return this->errorCode; }
 
+bool InputOptions::isWavefront() { return this->wavefront; }
+
 int GridFragment::getFirstRowIdxOwnedByProcess(int numPointsPerDimension,
                                                int numProcesses, int rank) {
   int numBase = numPointsPerDimension / numProcesses;
@@ -24,15 +24,23 @@ private:
   int numPointsPerDimension;
   bool verbose;
   int errorCode;
+  bool wavefront;
 
 public:
-  InputOptions(int numPointsPerDimension, bool verbose, int errorCode)
+  InputOptions(int numPointsPerDimension, bool verbose, int errorCode,
+               bool wavefront = false)
       : numPointsPerDimension(numPointsPerDimension), verbose(verbose),
-        errorCode(errorCode) {}
+        errorCode(errorCode), wavefront(wavefront) {}
 
   int getNumPointsPerDimension();
   bool isVerbose();
   int getErrorCode();
+
+  /**
+   * Whether several iterations are applied to a
+   * cache-resident band of rows at a time (sequential only).
+   */
+  bool isWavefront();
 };
 
 class Utils {
@@ -5,24 +5,36 @@
  */
 
 #include "laplace-common.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sys/time.h>
+#include <tuple>
 #include <vector>
 
 #define OPTION_VERBOSE "--verbose"
+#define OPTION_WAVEFRONT "--wavefront"
+
+/*
+ * Iterations applied to a band of rows before it moves on in the
+ * wavefront mode: 2 * WAVEFRONT_DEPTH + 2 rows stay in cache.
+ */
+#define WAVEFRONT_DEPTH 4
 
 static void printUsage(char const *progName) {
   std::cerr
       << "Usage:" << std::endl
-      << "    " << progName << " [--verbose] <N>" << std::endl
+      << "    " << progName << " [--verbose] [--wavefront] <N>" << std::endl
       << "Where:" << std::endl
       << "   <N>         The number of points in each dimension (at least 2)."
       << std::endl
       << "   " << OPTION_VERBOSE << "   Prints the input and output systems."
-      << std::endl;
+      << std::endl
+      << "   " << OPTION_WAVEFRONT << " Runs " << WAVEFRONT_DEPTH
+      << " iterations per pass over the grid and tests" << std::endl
+      << "               convergence after each pass." << std::endl;
 }
 
 static void freePointRow(const double *currentPointRow) {
@@ -64,7 +76,13 @@ static double **allocatePoints(int numPointsPerDimension) {
   return points;
 }
 
+/*
+ * With OpenMP, each thread first touches, and so places on its NUMA
+ * node, the rows it relaxes in performAlgorithm: the same loop and
+ * static schedule.
+ */
 static void initializePoints(double **points, int numPointsPerDimension) {
+#pragma omp parallel for schedule(static)
   for (int i = 0; i < numPointsPerDimension; ++i) {
     for (int j = 0; j < numPointsPerDimension; ++j) {
       points[i][j] = Utils::getInitialValue(i, j, numPointsPerDimension);
@@ -87,29 +105,35 @@ static void printPoints(double **points, int numPointsPerDimension) {
 static InputOptions parseInput(int argc, char *argv[]) {
   int numPointsPerDimension = 0;
   bool verbose = false;
+  bool wavefront = false;
   int errorCode = 0;
 
   if (argc < 2) {
     std::cerr << "ERROR: Too few arguments!" << std::endl;
     printUsage(argv[0]);
     errorCode = 1;
-  } else if (argc > 3) {
+  } else if (argc > 4) {
     std::cerr << "ERROR: Too many arguments!" << std::endl;
     printUsage(argv[0]);
     errorCode = 2;
   } else {
     int argIdx = 1;
 
-    if (argc == 3) {
-      if (strncmp(argv[argIdx], OPTION_VERBOSE, strlen(OPTION_VERBOSE)) != 0) {
+    for (; argIdx < argc - 1 && errorCode == 0; ++argIdx) {
+      if (strcmp(argv[argIdx], OPTION_VERBOSE) == 0) {
+        verbose = true;
+      } else if (strcmp(argv[argIdx], OPTION_WAVEFRONT) == 0) {
+        wavefront = true;
+      } else {
         std::cerr << "ERROR: Unexpected option '" << argv[argIdx] << "'!"
                   << std::endl;
         printUsage(argv[0]);
         errorCode = 3;
       }
+    }
 
-      verbose = true;
-      ++argIdx;
+    if (errorCode != 0) {
+      return {numPointsPerDimension, verbose, errorCode};
     }
 
     numPointsPerDimension = std::strtol(argv[argIdx], nullptr, 10);
@@ -124,37 +148,110 @@ static InputOptions parseInput(int argc, char *argv[]) {
     }
   }
 
-  return {numPointsPerDimension, verbose, errorCode};
+  return {numPointsPerDimension, verbose, errorCode, wavefront};
 }
 
+/* Relaxes the points of a color in row i; returns the max change. */
+static double relaxRow(double **points, int i, int color, double omega,
+                       int numPointsPerDimension) {
+  double maxDiff = 0.0;
+
+  for (int j = 1 + (i % 2 == color ? 1 : 0); j < numPointsPerDimension - 1;
+       j += 2) {
+    double tmp = (points[i - 1][j] + points[i + 1][j] + points[i][j - 1] +
+                  points[i][j + 1]) /
+                 4.0;
+    double prev = points[i][j];
+
+    points[i][j] = (1.0 - omega) * points[i][j] + omega * tmp;
+    double diff = fabs(prev - points[i][j]);
+
+    if (diff > maxDiff) {
+      maxDiff = diff;
+    }
+  }
+
+  return maxDiff;
+}
+
+/*
+ * With OpenMP, one team of threads runs all iterations. A sweep of a
+ * color reads only the other one, so its rows are split among the
+ * threads, in static blocks, and the barriers at the ends of the loops
+ * separate the sweeps. The result does not depend on the number of
+ * threads.
+ */
 std::tuple<int, double> performAlgorithm(double **points, double omega,
                                          double epsilon,
                                          int numPointsPerDimension) {
+  double maxDiff = 0.0;
+  double lastMaxDiff = 0.0;
+  bool converged = false;
+  int numIterations = 0;
+
+#pragma omp parallel
+  {
+    do {
+      for (int color = 0; color < 2; ++color) {
+        /* All rows, as in initializePoints; the fixed ones are skipped. */
+#pragma omp for schedule(static) reduction(max : maxDiff)
+        for (int i = 0; i < numPointsPerDimension; ++i) {
+          if (i > 0 && i < numPointsPerDimension - 1) {
+            maxDiff = std::max(maxDiff, relaxRow(points, i, color, omega,
+                                                 numPointsPerDimension));
+          }
+        }
+      }
+
+      /* Read by all threads before the next barrier; written only after it. */
+#pragma omp single
+      {
+        ++numIterations;
+        lastMaxDiff = maxDiff;
+        converged = maxDiff <= epsilon;
+        maxDiff = 0.0;
+      }
+    } while (!converged);
+  }
+
+  return std::make_tuple(numIterations, lastMaxDiff);
+}
+
+/*
+ * Runs WAVEFRONT_DEPTH iterations, 2 * WAVEFRONT_DEPTH color sweeps,
+ * in one pass over the grid. Sweep s trails sweep s - 1 by one row:
+ * when it relaxes row i, the sweep before has finished rows i - 1 to
+ * i + 1, which it reads, and the sweep after has not yet touched row
+ * i - 1, so every point sees the same values as in performAlgorithm.
+ * Convergence is tested after each pass, on its last iteration, so
+ * the result is that of performAlgorithm run for as many iterations.
+ */
+std::tuple<int, double> performAlgorithmWavefront(double **points,
+                                                  double omega, double epsilon,
+                                                  int numPointsPerDimension) {
+  int numSweeps = 2 * WAVEFRONT_DEPTH;
+  int lastRowIdx = numPointsPerDimension - 2;
   double maxDiff;
   int numIterations = 0;
 
   do {
     maxDiff = 0.0;
 
-    for (int color = 0; color < 2; ++color) {
-      for (int i = 1; i < numPointsPerDimension - 1; ++i) {
-        for (int j = 1 + (i % 2 == color ? 1 : 0);
-             j < numPointsPerDimension - 1; j += 2) {
-          double tmp = (points[i - 1][j] + points[i + 1][j] + points[i][j - 1] +
-                        points[i][j + 1]) /
-                       4.0;
-          double prev = points[i][j];
-
-          points[i][j] = (1.0 - omega) * points[i][j] + omega * tmp;
-          double diff = fabs(prev - points[i][j]);
+    for (int step = 1; step <= lastRowIdx + numSweeps - 1; ++step) {
+      for (int sweep = 0; sweep < numSweeps; ++sweep) {
+        int i = step - sweep;
+        if (i < 1 || i > lastRowIdx) {
+          continue;
+        }
 
-          if (diff > maxDiff) {
-            maxDiff = diff;
-          }
+        double diff =
+            relaxRow(points, i, sweep % 2, omega, numPointsPerDimension);
+        if (sweep >= numSweeps - 2) {
+          maxDiff = std::max(maxDiff, diff);
         }
       }
     }
-    ++numIterations;
+    numIterations += WAVEFRONT_DEPTH;
   } while (maxDiff > epsilon);
 
   return std::make_tuple(numIterations, maxDiff);
@@ -193,8 +290,11 @@ int main(int argc, char *argv[]) {
 
   /* Start of computations. */
 
-  auto result =
-      performAlgorithm(pointsPointer, omega, epsilon, numPointsPerDimension);
+  auto result = inputOptions.isWavefront()
+                    ? performAlgorithmWavefront(pointsPointer, omega, epsilon,
+                                                numPointsPerDimension)
+                    : performAlgorithm(pointsPointer, omega, epsilon,
+                                       numPointsPerDimension);
 
   /* End of computations. */
 
@@ -0,0 +1,129 @@
+#include "transpose-cpu.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <omp.h>
+
+#define NUM_REPS 10
+
+typedef void (*transpose_fn)(float *, const float *, int, int);
+
+static float *allocMatrix(size_t numElems) {
+  size_t bytes = (numElems * sizeof(float) + 63) / 64 * 64;
+  return (float *)aligned_alloc(64, bytes);
+}
+
+static void parallelCopy(float *dst, const float *src, size_t numElems) {
+#pragma omp parallel
+  {
+    int numThreads = omp_get_num_threads();
+    int tid = omp_get_thread_num();
+    size_t chunk = (numElems + numThreads - 1) / numThreads;
+    size_t begin = chunk * tid < numElems ? chunk * tid : numElems;
+    size_t end = begin + chunk < numElems ? begin + chunk : numElems;
+    memcpy(dst + begin, src + begin, (end - begin) * sizeof(float));
+  }
+}
+
+static int check(const float *output, const float *correct, int nx, int ny) {
+  for (int j = 0; j < nx; j++)
+    for (int i = 0; i < ny; i++)
+      if (output[(size_t)j * ny + i] != correct[(size_t)j * ny + i]) {
+        printf("Wrong value at (%d, %d), got %f, expected %f\n", i, j,
+               output[(size_t)j * ny + i], correct[(size_t)j * ny + i]);
+        return 1;
+      }
+  return 0;
+}
+
+static void report(const char *name, double seconds, size_t bytes,
+                   double copyBandwidth) {
+  double bandwidth = 2.0 * bytes / seconds / 1e9;
+  printf("%-12s %9.3f ms %8.2f GB/s", name, 1000 * seconds, bandwidth);
+  if (copyBandwidth > 0)
+    printf(" (%5.1f%% of memcpy)", 100 * bandwidth / copyBandwidth);
+  printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+  int nx = 8192;
+  int ny = 8192;
+  int reps = NUM_REPS;
+
+  if (argc >= 3) {
+    nx = atoi(argv[1]);
+    ny = atoi(argv[2]);
+  }
+  if (argc >= 4)
+    reps = atoi(argv[3]);
+  if (nx <= 0 || ny <= 0 || reps <= 0) {
+    printf("Usage: %s [nx ny [reps]]\n", argv[0]);
+    return 1;
+  }
+
+  size_t numElems = (size_t)nx * ny;
+  size_t bytes = numElems * sizeof(float);
+  float *host_input = allocMatrix(numElems), *host_correct = allocMatrix(numElems),
+        *host_output = allocMatrix(numElems);
+
+#pragma omp parallel for schedule(static)
+  for (int j = 0; j < ny; j++)
+    for (int i = 0; i < nx; i++)
+      host_input[(size_t)j * nx + i] = host_correct[(size_t)i * ny + j] =
+          (float)((size_t)j * nx + i);
+
+  printf("Transposing %d x %d floats with %d thread(s), best of %d runs\n", ny,
+         nx, omp_get_max_threads(), reps);
+
+  double best = 1e30;
+  for (int r = 0; r < reps; r++) {
+    double startTime = omp_get_wtime();
+    parallelCopy(host_output, host_input, numElems);
+    double elapsed = omp_get_wtime() - startTime;
+    best = elapsed < best ? elapsed : best;
+  }
+  double copyBandwidth = 2.0 * bytes / best / 1e9;
+  report("memcpy", best, bytes, 0);
+
+  const char *names[] = {"naive", "blocked", "recursive"};
+  transpose_fn kernels[] = {transposeNaive, transposeBlocked,
+                            transposeRecursive};
+
+  for (int k = 0; k < 3; k++) {
+    best = 1e30;
+    for (int r = 0; r < reps; r++) {
+      memset(host_output, 0, bytes);
+      double startTime = omp_get_wtime();
+      kernels[k](host_output, host_input, nx, ny);
+      double elapsed = omp_get_wtime() - startTime;
+      best = elapsed < best ? elapsed : best;
+    }
+    if (check(host_output, host_correct, nx, ny))
+      return 1;
+    report(names[k], best, bytes, copyBandwidth);
+  }
+
+  /* Every in-place run transposes the previous result back and forth. */
+  parallelCopy(host_output, host_input, numElems);
+  best = 1e30;
+  int curNx = nx, curNy = ny;
+  for (int r = 0; r < reps; r++) {
+    double startTime = omp_get_wtime();
+    transposeInPlace(host_output, curNx, curNy);
+    double elapsed = omp_get_wtime() - startTime;
+    best = elapsed < best ? elapsed : best;
+    int tmp = curNx;
+    curNx = curNy;
+    curNy = tmp;
+  }
+  if (reps % 2 == 0)
+    transposeInPlace(host_output, curNx, curNy);
+  if (check(host_output, host_correct, nx, ny))
+    return 1;
+  report("in-place", best, bytes, copyBandwidth);
+
+  free(host_input);
+  free(host_correct);
+  free(host_output);
+  return 0;
+}
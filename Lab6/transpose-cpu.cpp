@@ -0,0 +1,325 @@
+#include "transpose-cpu.h"
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <omp.h>
+#include <vector>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+/* Recursion levels that still spawn OpenMP tasks. */
+#define CPU_TASK_DEPTH 8
+
+/* Columns moved together by the column passes of the in-place transpose. */
+#define CPU_COLUMN_BLOCK 64
+
+/*
+ * Transposes one CPU_REG_DIM x CPU_REG_DIM block: reads 8 rows of
+ * src (stride srcStride) and writes them as 8 columns of dst.
+ */
+static inline void transpose8x8(float *dst, size_t dstStride,
+                                const float *src, size_t srcStride) {
+#ifdef __AVX__
+  __m256 r0 = _mm256_loadu_ps(src + 0 * srcStride);
+  __m256 r1 = _mm256_loadu_ps(src + 1 * srcStride);
+  __m256 r2 = _mm256_loadu_ps(src + 2 * srcStride);
+  __m256 r3 = _mm256_loadu_ps(src + 3 * srcStride);
+  __m256 r4 = _mm256_loadu_ps(src + 4 * srcStride);
+  __m256 r5 = _mm256_loadu_ps(src + 5 * srcStride);
+  __m256 r6 = _mm256_loadu_ps(src + 6 * srcStride);
+  __m256 r7 = _mm256_loadu_ps(src + 7 * srcStride);
+
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+  _mm256_storeu_ps(dst + 0 * dstStride, _mm256_permute2f128_ps(s0, s4, 0x20));
+  _mm256_storeu_ps(dst + 1 * dstStride, _mm256_permute2f128_ps(s1, s5, 0x20));
+  _mm256_storeu_ps(dst + 2 * dstStride, _mm256_permute2f128_ps(s2, s6, 0x20));
+  _mm256_storeu_ps(dst + 3 * dstStride, _mm256_permute2f128_ps(s3, s7, 0x20));
+  _mm256_storeu_ps(dst + 4 * dstStride, _mm256_permute2f128_ps(s0, s4, 0x31));
+  _mm256_storeu_ps(dst + 5 * dstStride, _mm256_permute2f128_ps(s1, s5, 0x31));
+  _mm256_storeu_ps(dst + 6 * dstStride, _mm256_permute2f128_ps(s2, s6, 0x31));
+  _mm256_storeu_ps(dst + 7 * dstStride, _mm256_permute2f128_ps(s3, s7, 0x31));
+#else
+  for (int i = 0; i < CPU_REG_DIM; i++)
+    for (int j = 0; j < CPU_REG_DIM; j++)
+      dst[j * dstStride + i] = src[i * srcStride + j];
+#endif
+}
+
+/*
+ * Transposes the input region with rows [y0, y1) and columns [x0, x1).
+ * Full register blocks go through transpose8x8, the ragged right and
+ * bottom strips are copied element by element.
+ */
+static void transposeRegion(float *odata, const float *idata, int nx, int ny,
+                            int x0, int x1, int y0, int y1) {
+  int xFull = x0 + (x1 - x0) / CPU_REG_DIM * CPU_REG_DIM;
+  int yFull = y0 + (y1 - y0) / CPU_REG_DIM * CPU_REG_DIM;
+
+  for (int y = y0; y < yFull; y += CPU_REG_DIM) {
+    for (int x = x0; x < xFull; x += CPU_REG_DIM) {
+      transpose8x8(odata + (size_t)x * ny + y, ny, idata + (size_t)y * nx + x,
+                   nx);
+    }
+    for (int yy = y; yy < y + CPU_REG_DIM; yy++)
+      for (int x = xFull; x < x1; x++)
+        odata[(size_t)x * ny + yy] = idata[(size_t)yy * nx + x];
+  }
+
+  for (int y = yFull; y < y1; y++)
+    for (int x = x0; x < x1; x++)
+      odata[(size_t)x * ny + y] = idata[(size_t)y * nx + x];
+}
+
+void transposeNaive(float *odata, const float *idata, int nx, int ny) {
+#pragma omp parallel for schedule(static)
+  for (int y = 0; y < ny; y++)
+    for (int x = 0; x < nx; x++)
+      odata[(size_t)x * ny + y] = idata[(size_t)y * nx + x];
+}
+
+void transposeBlocked(float *odata, const float *idata, int nx, int ny) {
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int y = 0; y < ny; y += CPU_TILE_DIM)
+    for (int x = 0; x < nx; x += CPU_TILE_DIM)
+      transposeRegion(odata, idata, nx, ny, x, std::min(x + CPU_TILE_DIM, nx),
+                      y, std::min(y + CPU_TILE_DIM, ny));
+}
+
+static void transposeRecursiveImpl(float *odata, const float *idata, int nx,
+                                   int ny, int x0, int x1, int y0, int y1,
+                                   int depth) {
+  int w = x1 - x0;
+  int h = y1 - y0;
+
+  if ((size_t)w * h <= CPU_RECURSION_LEAF || (w <= CPU_REG_DIM && h <= CPU_REG_DIM)) {
+    transposeRegion(odata, idata, nx, ny, x0, x1, y0, y1);
+    return;
+  }
+
+  /* Split points stay on register-block boundaries. */
+  if (w >= h) {
+    int xm = x0 + std::max(CPU_REG_DIM, (w / 2) / CPU_REG_DIM * CPU_REG_DIM);
+#pragma omp task if (depth < CPU_TASK_DEPTH)
+    transposeRecursiveImpl(odata, idata, nx, ny, x0, xm, y0, y1, depth + 1);
+    transposeRecursiveImpl(odata, idata, nx, ny, xm, x1, y0, y1, depth + 1);
+  } else {
+    int ym = y0 + std::max(CPU_REG_DIM, (h / 2) / CPU_REG_DIM * CPU_REG_DIM);
+#pragma omp task if (depth < CPU_TASK_DEPTH)
+    transposeRecursiveImpl(odata, idata, nx, ny, x0, x1, y0, ym, depth + 1);
+    transposeRecursiveImpl(odata, idata, nx, ny, x0, x1, ym, y1, depth + 1);
+  }
+#pragma omp taskwait
+}
+
+void transposeRecursive(float *odata, const float *idata, int nx, int ny) {
+#pragma omp parallel
+#pragma omp single
+  transposeRecursiveImpl(odata, idata, nx, ny, 0, nx, 0, ny, 0);
+}
+
+/*
+ * Square case: block (bi, bj) is swapped with the transpose of
+ * block (bj, bi), going through a small stack buffer.
+ */
+static void transposeSquareInPlace(float *data, int n) {
+  int full = n / CPU_REG_DIM * CPU_REG_DIM;
+  int numTiles = (full + CPU_TILE_DIM - 1) / CPU_TILE_DIM;
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+  for (int ti = 0; ti < numTiles; ti++) {
+    for (int tj = 0; tj < numTiles; tj++) {
+      if (tj < ti)
+        continue;
+      int iEnd = std::min((ti + 1) * CPU_TILE_DIM, full);
+      int jEnd = std::min((tj + 1) * CPU_TILE_DIM, full);
+      float tmp[CPU_REG_DIM * CPU_REG_DIM];
+
+      for (int i = ti * CPU_TILE_DIM; i < iEnd; i += CPU_REG_DIM) {
+        for (int j = std::max(tj * CPU_TILE_DIM, i); j < jEnd;
+             j += CPU_REG_DIM) {
+          float *a = data + (size_t)i * n + j;
+          float *b = data + (size_t)j * n + i;
+          transpose8x8(tmp, CPU_REG_DIM, a, n);
+          if (i != j)
+            transpose8x8(a, n, b, n);
+          for (int r = 0; r < CPU_REG_DIM; r++)
+            std::copy(tmp + r * CPU_REG_DIM, tmp + (r + 1) * CPU_REG_DIM,
+                      b + (size_t)r * n);
+        }
+      }
+    }
+  }
+
+  /* Strip to the right of the last full register block. */
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < n; i++)
+    for (int j = std::max(full, i + 1); j < n; j++)
+      std::swap(data[(size_t)i * n + j], data[(size_t)j * n + i]);
+}
+
+/* Copies columns [c0, c0 + w) of the m x n matrix data to column. */
+static void loadColumnBlock(float *column, const float *data, int m, int n,
+                            int c0, int w) {
+  for (int r = 0; r < m; r++)
+    std::copy(data + (size_t)r * n + c0, data + (size_t)r * n + c0 + w,
+              column + (size_t)r * CPU_COLUMN_BLOCK);
+}
+
+/* Rotates column j of the m x n matrix up by j / b rows. */
+static void rotateColumns(float *data, int m, int n, int b) {
+#pragma omp parallel
+  {
+    std::vector<float> column((size_t)m * CPU_COLUMN_BLOCK);
+    int shift[CPU_COLUMN_BLOCK];
+
+#pragma omp for schedule(static)
+    for (int c0 = 0; c0 < n; c0 += CPU_COLUMN_BLOCK) {
+      int w = std::min(CPU_COLUMN_BLOCK, n - c0);
+      loadColumnBlock(column.data(), data, m, n, c0, w);
+      for (int c = 0; c < w; c++)
+        shift[c] = (c0 + c) / b;
+
+      for (int r = 0; r < m; r++) {
+        float *out = data + (size_t)r * n + c0;
+        for (int c = 0; c < w; c++) {
+          int src = r + shift[c];
+          out[c] = column[(size_t)(src >= m ? src - m : src) * CPU_COLUMN_BLOCK + c];
+        }
+      }
+    }
+  }
+}
+
+/* Moves element j of row r to (j * m + (r + j / b) mod m) mod n. */
+static void shuffleRows(float *data, int m, int n, int b) {
+  int g = n / b;
+
+  /* (j * m) mod n and j / b, the same for every row. */
+  std::vector<int> base(n);
+  std::vector<int> group(n);
+  for (int j = 1; j < n; j++) {
+    int next = base[j - 1] + m % n;
+    base[j] = next >= n ? next - n : next;
+    group[j] = j / b;
+  }
+
+#pragma omp parallel
+  {
+    std::vector<float> row(n);
+    std::vector<int> shift(g);
+
+#pragma omp for schedule(static)
+    for (int r = 0; r < m; r++) {
+      float *rowData = data + (size_t)r * n;
+
+      /* (r + q) mod m, reduced mod n. */
+      shift[0] = r % n;
+      for (int q = 1, source = r + 1; q < g; q++, source++) {
+        if (source == m)
+          source = 0;
+        int next = shift[q - 1] + 1;
+        shift[q] = source == 0 ? 0 : next == n ? 0 : next;
+      }
+
+      for (int j = 0; j < n; j++) {
+        int dst = base[j] + shift[group[j]];
+        row[dst >= n ? dst - n : dst] = rowData[j];
+      }
+      std::copy(row.begin(), row.end(), rowData);
+    }
+  }
+}
+
+/*
+ * Fills index l = r * n + c of the m x n matrix from row
+ * (i - j / b) mod m of column c, where i = l mod m and j = l / m.
+ */
+static void shuffleColumns(float *data, int m, int n, int b) {
+#pragma omp parallel
+  {
+    std::vector<float> column((size_t)m * CPU_COLUMN_BLOCK);
+
+#pragma omp for schedule(static)
+    for (int c0 = 0; c0 < n; c0 += CPU_COLUMN_BLOCK) {
+      int w = std::min(CPU_COLUMN_BLOCK, n - c0);
+      loadColumnBlock(column.data(), data, m, n, c0, w);
+
+      /* i and j = jq * b + jr for l = r * n + c0, updated row by row. */
+      int i = c0 % m;
+      int jq = c0 / m / b;
+      int jr = c0 / m % b;
+      for (int r = 0; r < m; r++) {
+        float *out = data + (size_t)r * n + c0;
+        int ii = i, qq = jq, rr = jr;
+        for (int c = 0; c < w; c++) {
+          int src = ii - qq;
+          out[c] = column[(size_t)(src < 0 ? src + m : src) * CPU_COLUMN_BLOCK + c];
+          if (++ii == m) {
+            ii = 0;
+            if (++rr == b) {
+              rr = 0;
+              qq++;
+            }
+          }
+        }
+
+        i += n % m;
+        jr += n / m;
+        if (i >= m) {
+          i -= m;
+          jr++;
+        }
+        while (jr >= b) {
+          jr -= b;
+          jq++;
+        }
+      }
+    }
+  }
+}
+
+/*
+ * Non-square case, after Catanzaro et al., "A Decomposition for
+ * In-place Matrix Transposition": with m = ny rows, n = nx columns
+ * and b = n / gcd(m, n), element (i, j) ends up at index j * m + i
+ * after three passes, each permuting only within columns or only
+ * within rows. Every pass streams through the matrix with a buffer
+ * of a row or of CPU_COLUMN_BLOCK columns per thread, rather than
+ * following the cycles of the permutation one element at a time.
+ */
+static void transposeRectInPlace(float *data, int nx, int ny) {
+  int m = ny;
+  int n = nx;
+  int b = n / std::gcd(m, n);
+
+  /* Every rotation is by 0 rows when m and n are coprime. */
+  if (b < n)
+    rotateColumns(data, m, n, b);
+  shuffleRows(data, m, n, b);
+  shuffleColumns(data, m, n, b);
+}
+
+void transposeInPlace(float *data, int nx, int ny) {
+  if (nx == ny)
+    transposeSquareInPlace(data, nx);
+  else if (nx > 1 && ny > 1)
+    transposeRectInPlace(data, nx, ny);
+}
@@ -0,0 +1,48 @@
+#ifndef __TRANSPOSE_CPU_H__
+#define __TRANSPOSE_CPU_H__
+
+/*
+ * CPU counterparts of the tiled GPU transpose from transpose.cu.
+ *
+ * The input is a row-major matrix with ny rows and nx columns
+ * (idata[y * nx + x]). The output is its transpose, a row-major
+ * matrix with nx rows and ny columns (odata[x * ny + y]).
+ * All kernels accept arbitrary nx and ny and are OpenMP-parallel.
+ */
+
+/* Edge of a cache tile; a tile of both matrices fits in L1. */
+#define CPU_TILE_DIM 64
+
+/* Edge of a register block transposed with AVX shuffles. */
+#define CPU_REG_DIM 8
+
+/* Below this many elements the recursive kernel stops splitting. */
+#define CPU_RECURSION_LEAF 4096
+
+/**
+ * Reference element-by-element transpose.
+ */
+void transposeNaive(float *odata, const float *idata, int nx, int ny);
+
+/**
+ * Cache-tiled transpose. Each CPU_TILE_DIM x CPU_TILE_DIM tile is
+ * transposed with 8x8 AVX register blocks; ragged edges fall back
+ * to scalar code.
+ */
+void transposeBlocked(float *odata, const float *idata, int nx, int ny);
+
+/**
+ * Cache-oblivious transpose: recursively halves the longer side
+ * until a block fits in cache, then uses the register-block kernel.
+ */
+void transposeRecursive(float *odata, const float *idata, int nx, int ny);
+
+/**
+ * In-place transpose of a ny x nx matrix into a nx x ny one.
+ * Square matrices swap tile pairs across the diagonal; other
+ * shapes are permuted within columns, then rows, then columns
+ * again, with a buffer of a few columns per thread.
+ */
+void transposeInPlace(float *data, int nx, int ny);
+
+#endif /* __TRANSPOSE_CPU_H__ */
@@ -0,0 +1,286 @@
+/*
+ * Latency/bandwidth microbenchmarks for MPI point-to-point
+ * and collective operations.
+ *
+ * Every measured repetition is written to a CSV file
+ * (test,ranks,len,try,time,bytes) that draw-bandwidth.ipynb
+ * can load directly; a percentile summary goes to stdout.
+ */
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_TRIES 30
+#define DEFAULT_MAX_BYTES (64 << 20)
+#define DEFAULT_COLL_MAX_BYTES (1 << 20)
+#define DEFAULT_WINDOW 64
+#define DEFAULT_OUTPUT "bench.csv"
+#define ALL_TESTS "pingpong,stream,bistream,bcast,allreduce,alltoall,scatter,gather"
+
+typedef struct {
+  int tries;
+  int maxBytes;
+  int collMaxBytes;
+  int window;
+  const char *tests;
+  const char *output;
+} Options;
+
+static int rank, numProcesses;
+static FILE *csv;
+static char *sendBuf, *recvBuf;
+
+static void printUsage(const char *progName) {
+  fprintf(stderr,
+          "Usage: %s [-t tests] [-n tries] [-m max_bytes] [-c coll_max_bytes]"
+          " [-w window] [-o file.csv]\n"
+          "  tests: comma separated subset of " ALL_TESTS "\n",
+          progName);
+}
+
+static int hasTest(const Options *opts, const char *name) {
+  size_t len = strlen(name);
+  const char *p = opts->tests;
+  while ((p = strstr(p, name)) != NULL) {
+    if ((p == opts->tests || p[-1] == ',') && (p[len] == ',' || p[len] == 0))
+      return 1;
+    p += len;
+  }
+  return 0;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int n, double p) {
+  int idx = (int)(p / 100.0 * n + 0.5) - 1;
+  if (idx < 0)
+    idx = 0;
+  if (idx >= n)
+    idx = n - 1;
+  return sorted[idx];
+}
+
+/* Called on rank 0 only: dumps tries to CSV and prints the summary. */
+static void record(const char *test, int ranks, int len, double *times,
+                   int tries, double bytesPerTry) {
+  for (int t = 0; t < tries; t++)
+    fprintf(csv, "%s,%d,%d,%d,%.9e,%.0f\n", test, ranks, len, t, times[t],
+            bytesPerTry);
+
+  qsort(times, tries, sizeof(double), compareDoubles);
+  double p50 = percentile(times, tries, 50);
+  printf("%-10s %5d %10d %12.2f %12.2f %12.2f %12.2f %12.2f\n", test, ranks,
+         len, 1e6 * times[0], 1e6 * p50, 1e6 * percentile(times, tries, 90),
+         1e6 * percentile(times, tries, 99), bytesPerTry / p50 / 1e6);
+}
+
+static void benchPingPong(const Options *opts, double *times) {
+  for (int len = 1; len <= opts->maxBytes; len *= 2) {
+    for (int t = -1; t < opts->tries; t++) {
+      MPI_Barrier(MPI_COMM_WORLD);
+      double startTime = MPI_Wtime();
+      if (rank == 0) {
+        MPI_Send(sendBuf, len, MPI_BYTE, 1, 0, MPI_COMM_WORLD);
+        MPI_Recv(recvBuf, len, MPI_BYTE, 1, 0, MPI_COMM_WORLD,
+                 MPI_STATUS_IGNORE);
+      } else if (rank == 1) {
+        MPI_Recv(recvBuf, len, MPI_BYTE, 0, 0, MPI_COMM_WORLD,
+                 MPI_STATUS_IGNORE);
+        MPI_Send(sendBuf, len, MPI_BYTE, 0, 0, MPI_COMM_WORLD);
+      }
+      if (t >= 0)
+        times[t] = MPI_Wtime() - startTime;
+    }
+    if (rank == 0)
+      record("pingpong", 2, len, times, opts->tries, 2.0 * len);
+  }
+}
+
+/*
+ * A window of non-blocking messages between ranks 0 and 1,
+ * closed by a zero-byte acknowledgement. The window shrinks
+ * for large messages so that it never exceeds max_bytes.
+ */
+static void benchStream(const Options *opts, double *times, int bidirectional) {
+  MPI_Request *requests = malloc(2 * opts->window * sizeof(MPI_Request));
+  const char *name = bidirectional ? "bistream" : "stream";
+
+  for (int len = 1; len <= opts->maxBytes; len *= 2) {
+    int window = opts->maxBytes / len < opts->window ? opts->maxBytes / len
+                                                      : opts->window;
+    for (int t = -1; t < opts->tries; t++) {
+      MPI_Barrier(MPI_COMM_WORLD);
+      double startTime = MPI_Wtime();
+      if (rank <= 1) {
+        int peer = 1 - rank;
+        int numRequests = 0;
+        if (rank == 1 || bidirectional)
+          for (int w = 0; w < window; w++)
+            MPI_Irecv(recvBuf + (size_t)w * len, len, MPI_BYTE, peer, 1,
+                      MPI_COMM_WORLD, &requests[numRequests++]);
+        if (rank == 0 || bidirectional)
+          for (int w = 0; w < window; w++)
+            MPI_Isend(sendBuf, len, MPI_BYTE, peer, 1, MPI_COMM_WORLD,
+                      &requests[numRequests++]);
+        MPI_Waitall(numRequests, requests, MPI_STATUSES_IGNORE);
+        if (rank == 0)
+          MPI_Recv(NULL, 0, MPI_BYTE, 1, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        else
+          MPI_Send(NULL, 0, MPI_BYTE, 0, 2, MPI_COMM_WORLD);
+      }
+      if (t >= 0)
+        times[t] = MPI_Wtime() - startTime;
+    }
+    if (rank == 0)
+      record(name, 2, len, times, opts->tries,
+             (bidirectional ? 2.0 : 1.0) * window * len);
+  }
+  free(requests);
+}
+
+/*
+ * Runs one collective on comm; the time of a try is the
+ * slowest rank's time. For the rooted and personalized
+ * collectives len is the block size per rank.
+ */
+static double runCollective(const char *test, MPI_Comm comm, int len) {
+  MPI_Barrier(comm);
+  double startTime = MPI_Wtime();
+  if (strcmp(test, "bcast") == 0)
+    MPI_Bcast(sendBuf, len, MPI_BYTE, 0, comm);
+  else if (strcmp(test, "allreduce") == 0)
+    MPI_Allreduce(sendBuf, recvBuf, len, MPI_UNSIGNED_CHAR, MPI_MAX, comm);
+  else if (strcmp(test, "alltoall") == 0)
+    MPI_Alltoall(sendBuf, len, MPI_BYTE, recvBuf, len, MPI_BYTE, comm);
+  else if (strcmp(test, "scatter") == 0)
+    MPI_Scatter(sendBuf, len, MPI_BYTE, recvBuf, len, MPI_BYTE, 0, comm);
+  else if (strcmp(test, "gather") == 0)
+    MPI_Gather(sendBuf, len, MPI_BYTE, recvBuf, len, MPI_BYTE, 0, comm);
+  double elapsed = MPI_Wtime() - startTime;
+  double slowest;
+  MPI_Reduce(&elapsed, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+  return slowest;
+}
+
+/* Payload that crosses the network per try, used for the MB/s column. */
+static double collectiveBytes(const char *test, int ranks, int len) {
+  if (strcmp(test, "alltoall") == 0)
+    return (double)ranks * (ranks - 1) * len;
+  if (strcmp(test, "allreduce") == 0)
+    return 2.0 * (ranks - 1) * len;
+  return (double)(ranks - 1) * len;
+}
+
+/* Repeats the collective on the first 2, 4, 8, ... ranks and on all of them. */
+static void benchCollective(const Options *opts, double *times,
+                            const char *test) {
+  for (int ranks = 2;; ranks *= 2) {
+    if (ranks > numProcesses)
+      ranks = numProcesses;
+    MPI_Comm comm;
+    MPI_Comm_split(MPI_COMM_WORLD, rank < ranks ? 0 : MPI_UNDEFINED, rank,
+                   &comm);
+    if (comm != MPI_COMM_NULL) {
+      for (int len = 1; len <= opts->collMaxBytes; len *= 2) {
+        for (int t = -1; t < opts->tries; t++) {
+          double elapsed = runCollective(test, comm, len);
+          if (t >= 0)
+            times[t] = elapsed;
+        }
+        if (rank == 0)
+          record(test, ranks, len, times, opts->tries,
+                 collectiveBytes(test, ranks, len));
+      }
+      MPI_Comm_free(&comm);
+    }
+    if (ranks == numProcesses)
+      break;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Options opts = {DEFAULT_TRIES,  DEFAULT_MAX_BYTES, DEFAULT_COLL_MAX_BYTES,
+                  DEFAULT_WINDOW, ALL_TESTS,         DEFAULT_OUTPUT};
+  int opt;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  while ((opt = getopt(argc, argv, "t:n:m:c:w:o:")) != -1) {
+    switch (opt) {
+    case 't': opts.tests = optarg; break;
+    case 'n': opts.tries = atoi(optarg); break;
+    case 'm': opts.maxBytes = atoi(optarg); break;
+    case 'c': opts.collMaxBytes = atoi(optarg); break;
+    case 'w': opts.window = atoi(optarg); break;
+    case 'o': opts.output = optarg; break;
+    default:
+      if (rank == 0)
+        printUsage(argv[0]);
+      MPI_Finalize();
+      return 1;
+    }
+  }
+
+  if (numProcesses < 2 || opts.tries <= 0 || opts.maxBytes <= 0 ||
+      opts.collMaxBytes <= 0 || opts.window <= 0) {
+    if (rank == 0) {
+      fprintf(stderr, "ERROR: needs at least 2 processes and positive sizes\n");
+      printUsage(argv[0]);
+    }
+    MPI_Finalize();
+    return 1;
+  }
+
+  size_t collBytes = (size_t)opts.collMaxBytes * numProcesses;
+  size_t p2pBytes = (size_t)opts.maxBytes;
+  size_t bufBytes = collBytes > p2pBytes ? collBytes : p2pBytes;
+  sendBuf = malloc(bufBytes);
+  recvBuf = malloc(bufBytes);
+  double *times = malloc(opts.tries * sizeof(double));
+  if (sendBuf == NULL || recvBuf == NULL || times == NULL) {
+    fprintf(stderr, "ERROR: rank %d cannot allocate %zu bytes\n", rank,
+            2 * bufBytes);
+    MPI_Abort(MPI_COMM_WORLD, 2);
+  }
+  memset(sendBuf, rank, bufBytes);
+  memset(recvBuf, 0, bufBytes);
+
+  if (rank == 0) {
+    csv = fopen(opts.output, "w");
+    if (csv == NULL) {
+      fprintf(stderr, "ERROR: cannot open %s\n", opts.output);
+      MPI_Abort(MPI_COMM_WORLD, 3);
+    }
+    fprintf(csv, "test,ranks,len,try,time,bytes\n");
+    printf("%-10s %5s %10s %12s %12s %12s %12s %12s\n", "test", "ranks",
+           "len[B]", "min[us]", "p50[us]", "p90[us]", "p99[us]", "MB/s(p50)");
+  }
+
+  if (hasTest(&opts, "pingpong"))
+    benchPingPong(&opts, times);
+  if (hasTest(&opts, "stream"))
+    benchStream(&opts, times, 0);
+  if (hasTest(&opts, "bistream"))
+    benchStream(&opts, times, 1);
+
+  const char *collectives[] = {"bcast", "allreduce", "alltoall", "scatter",
+                               "gather"};
+  for (int c = 0; c < 5; c++)
+    if (hasTest(&opts, collectives[c]))
+      benchCollective(&opts, times, collectives[c]);
+
+  if (rank == 0)
+    fclose(csv);
+  free(times);
+  free(sendBuf);
+  free(recvBuf);
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,164 @@
+#include "ring-allreduce.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RING_TAG 77
+
+typedef struct {
+  char *data;
+  char *tmp[2];
+  MPI_Request *recvRequests[2];
+  MPI_Request *sendRequests[2];
+  MPI_Datatype datatype;
+  MPI_Aint extent;
+  MPI_Comm comm;
+  int count;
+  int numProcesses;
+  int rank;
+  int chunkCount;
+  int numChunks;
+} Ring;
+
+static int segmentStart(const Ring *ring, int seg) {
+  int base = ring->count / ring->numProcesses;
+  int extra = ring->count % ring->numProcesses;
+  return seg * base + (seg < extra ? seg : extra);
+}
+
+/*
+ * Steps 0 .. p-2 form the reduce-scatter, steps p-1 .. 2p-3 the
+ * all-gather. The segment received at a step is the one sent at
+ * the following step.
+ */
+static int receivedSegment(const Ring *ring, int step) {
+  int p = ring->numProcesses;
+  int shift = step < p - 1 ? step + 1 : step - (p - 1);
+  return (ring->rank - shift + p) % p;
+}
+
+static int sentSegment(const Ring *ring, int step) {
+  return step == 0 ? ring->rank : receivedSegment(ring, step - 1);
+}
+
+/* Number of elements of chunk j of a segment (may be zero). */
+static int chunkLength(const Ring *ring, int seg, int j) {
+  int segLen = segmentStart(ring, seg + 1) - segmentStart(ring, seg);
+  int len = segLen - j * ring->chunkCount;
+  if (len > ring->chunkCount)
+    len = ring->chunkCount;
+  return len > 0 ? len : 0;
+}
+
+static char *chunkAddress(const Ring *ring, int seg, int j) {
+  return ring->data +
+         ((size_t)segmentStart(ring, seg) + (size_t)j * ring->chunkCount) *
+             ring->extent;
+}
+
+static void postReceives(Ring *ring, int step) {
+  int seg = receivedSegment(ring, step);
+  int left = (ring->rank - 1 + ring->numProcesses) % ring->numProcesses;
+  for (int j = 0; j < ring->numChunks; j++)
+    MPI_Irecv(ring->tmp[step % 2] + (size_t)j * ring->chunkCount * ring->extent,
+              chunkLength(ring, seg, j), ring->datatype, left, RING_TAG,
+              ring->comm, &ring->recvRequests[step % 2][j]);
+}
+
+static void postSend(Ring *ring, int step, int j) {
+  int seg = sentSegment(ring, step);
+  int right = (ring->rank + 1) % ring->numProcesses;
+  MPI_Isend(chunkAddress(ring, seg, j), chunkLength(ring, seg, j),
+            ring->datatype, right, RING_TAG, ring->comm,
+            &ring->sendRequests[step % 2][j]);
+}
+
+static void freeRingBuffers(Ring *ring) {
+  for (int b = 0; b < 2; b++) {
+    free(ring->tmp[b]);
+    free(ring->recvRequests[b]);
+    free(ring->sendRequests[b]);
+  }
+}
+
+int ringAllreduce(const void *sendbuf, void *recvbuf, int count,
+                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                  int chunkBytes) {
+  Ring ring;
+  int commutative;
+  MPI_Aint lowerBound;
+
+  MPI_Comm_size(comm, &ring.numProcesses);
+  MPI_Comm_rank(comm, &ring.rank);
+  MPI_Op_commutative(op, &commutative);
+
+  if (!commutative || ring.numProcesses == 1 || count < ring.numProcesses)
+    return MPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+
+  MPI_Type_get_extent(datatype, &lowerBound, &ring.extent);
+  if (sendbuf != MPI_IN_PLACE)
+    memcpy(recvbuf, sendbuf, (size_t)count * ring.extent);
+
+  if (chunkBytes <= 0)
+    chunkBytes = RING_ALLREDUCE_CHUNK_BYTES;
+  ring.data = recvbuf;
+  ring.datatype = datatype;
+  ring.comm = comm;
+  ring.count = count;
+  ring.chunkCount = chunkBytes / ring.extent > 0 ? chunkBytes / ring.extent : 1;
+
+  /* Segment 0 is never shorter than any other segment. */
+  int maxSegLen = segmentStart(&ring, 1);
+  ring.numChunks = (maxSegLen + ring.chunkCount - 1) / ring.chunkCount;
+  int noMemory = 0;
+  for (int b = 0; b < 2; b++) {
+    ring.tmp[b] = malloc((size_t)maxSegLen * ring.extent);
+    ring.recvRequests[b] = malloc(ring.numChunks * sizeof(MPI_Request));
+    ring.sendRequests[b] = malloc(ring.numChunks * sizeof(MPI_Request));
+    if (ring.tmp[b] == NULL || ring.recvRequests[b] == NULL ||
+        ring.sendRequests[b] == NULL)
+      noMemory = 1;
+  }
+
+  /* All ranks must take the same path, or the ring deadlocks. */
+  MPI_Allreduce(MPI_IN_PLACE, &noMemory, 1, MPI_INT, MPI_LOR, comm);
+  if (noMemory) {
+    freeRingBuffers(&ring);
+    return MPI_Allreduce(MPI_IN_PLACE, recvbuf, count, datatype, op, comm);
+  }
+
+  int numSteps = 2 * (ring.numProcesses - 1);
+  postReceives(&ring, 0);
+  for (int j = 0; j < ring.numChunks; j++)
+    postSend(&ring, 0, j);
+
+  for (int step = 0; step < numSteps; step++) {
+    /* The buffers of step - 1 are reused by step + 1. */
+    if (step > 0)
+      MPI_Waitall(ring.numChunks, ring.sendRequests[(step - 1) % 2],
+                  MPI_STATUSES_IGNORE);
+    if (step + 1 < numSteps)
+      postReceives(&ring, step + 1);
+
+    int seg = receivedSegment(&ring, step);
+    for (int j = 0; j < ring.numChunks; j++) {
+      int len = chunkLength(&ring, seg, j);
+      char *received =
+          ring.tmp[step % 2] + (size_t)j * ring.chunkCount * ring.extent;
+
+      MPI_Wait(&ring.recvRequests[step % 2][j], MPI_STATUS_IGNORE);
+      if (step < ring.numProcesses - 1)
+        MPI_Reduce_local(received, chunkAddress(&ring, seg, j), len, datatype,
+                         op);
+      else
+        memcpy(chunkAddress(&ring, seg, j), received, (size_t)len * ring.extent);
+
+      if (step + 1 < numSteps)
+        postSend(&ring, step + 1, j);
+    }
+  }
+  MPI_Waitall(ring.numChunks, ring.sendRequests[(numSteps - 1) % 2],
+              MPI_STATUSES_IGNORE);
+
+  freeRingBuffers(&ring);
+  return MPI_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#ifndef __RING_ALLREDUCE_H__
+#define __RING_ALLREDUCE_H__
+
+#include <mpi.h>
+
+/* Default size of a single pipelined message. */
+#define RING_ALLREDUCE_CHUNK_BYTES (256 << 10)
+
+/*
+ * Bandwidth-optimal all-reduce over the ring rank -> rank + 1.
+ *
+ * The vector is split into one segment per rank. A reduce-scatter
+ * leaves every rank with one fully reduced segment, then an
+ * all-gather circulates the reduced segments. Each segment travels
+ * in chunks of chunkBytes, and every chunk is forwarded as soon as
+ * it has been received, so consecutive steps overlap.
+ *
+ * Arguments follow MPI_Allreduce (sendbuf may be MPI_IN_PLACE);
+ * op may be a user operation from MPI_Op_create. Non-commutative
+ * operations fall back to MPI_Allreduce, since the ring combines
+ * contributions in rotated order. If any rank cannot allocate
+ * its staging buffers, all ranks fall back to MPI_Allreduce
+ * together. chunkBytes <= 0 selects RING_ALLREDUCE_CHUNK_BYTES.
+ */
+int ringAllreduce(const void *sendbuf, void *recvbuf, int count,
+                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                  int chunkBytes);
+
+#endif /* __RING_ALLREDUCE_H__ */
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+# Checks that every engine of floyd-warshall-par, and floyd-warshall-seq,
+# print the same distances for the same edge lists. Without edge lists,
+# uses a small graph with negative weights and unreachable pairs.
+
+if [ $# -lt 1 ]; then
+    >&2 echo -e "Usage: compare-engines.sh <NUM_PROCESSES> [<EDGE_LIST>...]\n\nRun make first; the binaries are taken from the directory of this script."
+    exit 1
+fi
+
+DIR=$(dirname "$0")
+NUM_PROCESSES=$1
+shift
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+if [ $# -eq 0 ]; then
+    # 1 -> 2 -> 3 -> 1 has a negative edge, and nothing reaches 4.
+    printf "0 1 5\n1 2 -3\n2 3 4\n4 0 2\n3 1 1\n" > "${WORK_DIR}/negative.txt"
+    set -- "${WORK_DIR}/negative.txt"
+fi
+
+ENGINES=("default:" "look-ahead:--look-ahead" "blocked:--blocked" "narrow:--narrow"
+         "squaring:--squaring" "johnson:--johnson" "auto:--auto")
+STATUS=0
+
+for EDGE_LIST in "$@"; do
+    "${DIR}/floyd-warshall-seq" --show-results --edge-list "${EDGE_LIST}" \
+        > "${WORK_DIR}/expected.txt" 2> /dev/null
+
+    for ENGINE in "${ENGINES[@]}"; do
+        NAME=${ENGINE%%:*}
+        OPTION=${ENGINE#*:}
+        mpirun ${MPIRUN_FLAGS} -np "${NUM_PROCESSES}" "${DIR}/floyd-warshall-par" ${OPTION} \
+            --show-results --edge-list "${EDGE_LIST}" > "${WORK_DIR}/actual.txt" 2> /dev/null
+        # The distances are printed twice, before and after the algorithm.
+        if cmp -s "${WORK_DIR}/expected.txt" "${WORK_DIR}/actual.txt"; then
+            printf "%-40s %12s  ok\n" "${EDGE_LIST}" "${NAME}"
+        else
+            printf "%-40s %12s  DIFFERS\n" "${EDGE_LIST}" "${NAME}"
+            STATUS=1
+        fi
+    done
+done
+
+exit ${STATUS}
@@ -0,0 +1,146 @@
+/*
+ * Floyd-Warshall over a 2D block-cyclic distribution: for every k
+ * the pivot row segment travels only down process columns and the
+ * pivot column segment only along process rows, so a process
+ * receives O(m / sqrt(p)) elements per iteration instead of O(m).
+ */
+
+#include "graph-2d.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <mpi.h>
+#include <string>
+
+#define DEFAULT_BLOCK_SIZE 64
+
+static void runFloydWarshall2D(GraphBlock2D *graph, ProcessGrid *grid) {
+  int m = graph->numVertices;
+  int b = graph->blockSize;
+  int numLocalRows = graph->numLocalRows;
+  int numLocalCols = graph->numLocalCols;
+  int *pivotRow = new int[std::max(numLocalCols, 1)];
+  int *pivotCol = new int[std::max(numLocalRows, 1)];
+
+  for (int k = 0; k < m; ++k) {
+    int rowOwner = getOwnerOfIndex(k, b, grid->numProcRows);
+    int colOwner = getOwnerOfIndex(k, b, grid->numProcCols);
+
+    if (grid->myProcRow == rowOwner) {
+      int lk = getLocalIndex(k, b, grid->numProcRows);
+      std::copy(graph->data + (size_t)lk * numLocalCols,
+                graph->data + (size_t)(lk + 1) * numLocalCols, pivotRow);
+    }
+    if (grid->myProcCol == colOwner) {
+      int lk = getLocalIndex(k, b, grid->numProcCols);
+      for (int li = 0; li < numLocalRows; ++li) {
+        pivotCol[li] = graph->data[(size_t)li * numLocalCols + lk];
+      }
+    }
+
+    MPI_Bcast(pivotRow, numLocalCols, MPI_INT, rowOwner, grid->colComm);
+    MPI_Bcast(pivotCol, numLocalRows, MPI_INT, colOwner, grid->rowComm);
+
+    for (int li = 0; li < numLocalRows; ++li) {
+      int *row = graph->data + (size_t)li * numLocalCols;
+      int distToPivot = pivotCol[li];
+      for (int lj = 0; lj < numLocalCols; ++lj) {
+        int pathSum = distToPivot + pivotRow[lj];
+        if (row[lj] > pathSum) {
+          row[lj] = pathSum;
+        }
+      }
+    }
+  }
+
+  delete[] pivotRow;
+  delete[] pivotCol;
+}
+
+int main(int argc, char *argv[]) {
+  int numVertices = 0;
+  int numProcesses = 0;
+  int myRank = 0;
+  int showResults = 0;
+  int blockSize = DEFAULT_BLOCK_SIZE;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+  MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]).compare("--show-results") == 0) {
+      showResults = 1;
+    } else if (std::string(argv[i]).compare("--block-size") == 0 &&
+               i + 1 < argc) {
+      blockSize = std::stoi(argv[++i]);
+    } else {
+      numVertices = std::stoi(argv[i]);
+    }
+  }
+
+  if (numVertices <= 0 || blockSize <= 0) {
+    std::cerr << "Usage: " << argv[0]
+              << "  [--show-results] [--block-size <b>] <num_vertices>"
+              << std::endl;
+    MPI_Finalize();
+    return 1;
+  }
+
+  /* Every process of the grid should own at least one block row and column. */
+  int numBlocks = (numVertices + blockSize - 1) / blockSize;
+  int numActive = std::min(numProcesses, numBlocks * numBlocks);
+  for (;; --numActive) {
+    int dims[2] = {0, 0};
+    MPI_Dims_create(numActive, 2, dims);
+    if (dims[0] <= numBlocks && dims[1] <= numBlocks) {
+      break;
+    }
+  }
+
+  MPI_Comm activeComm;
+  MPI_Comm_split(MPI_COMM_WORLD, myRank < numActive ? 0 : MPI_UNDEFINED,
+                 myRank, &activeComm);
+  if (activeComm == MPI_COMM_NULL) {
+    MPI_Finalize();
+    return 0;
+  }
+
+  auto grid = createProcessGrid(activeComm);
+
+  if (grid->myRank == 0) {
+    std::cerr << "Running the Floyd-Warshall algorithm for a graph with "
+              << numVertices << " vertices on a " << grid->numProcRows << "x"
+              << grid->numProcCols << " process grid." << std::endl;
+  }
+
+  auto graph = createAndDistributeGraph2D(numVertices, blockSize, grid);
+
+  if (showResults) {
+    collectAndPrintGraph2D(graph, grid);
+  }
+
+  double startTime = MPI_Wtime();
+
+  runFloydWarshall2D(graph, grid);
+
+  double endTime = MPI_Wtime();
+  if (grid->myRank == 0) {
+    std::cerr << "The time required for the Floyd-Warshall algorithm on a "
+              << numVertices << "-node graph with "
+              << grid->numProcRows * grid->numProcCols
+              << " process(es): " << endTime - startTime << std::endl;
+  }
+
+  if (showResults) {
+    collectAndPrintGraph2D(graph, grid);
+  }
+
+  destroyGraph2D(graph);
+  freeProcessGrid(grid);
+  MPI_Comm_free(&activeComm);
+
+  MPI_Finalize();
+
+  return 0;
+}
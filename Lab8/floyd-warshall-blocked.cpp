@@ -0,0 +1,111 @@
+/*
+ * Three-phase blocked (tiled) Floyd-Warshall kernel.
+ */
+
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "floyd-warshall-blocked.h"
+#include "graph-base.h"
+#include "min-plus-gemm.h"
+
+void minPlusRow(int* dst, int const* src, int w, int n) {
+    int j = 0;
+
+    if (w >= GRAPH_INFINITY) {
+        return;
+    }
+
+#ifdef __AVX2__
+    __m256i weight = _mm256_set1_epi32(w);
+    __m256i infinity = _mm256_set1_epi32(GRAPH_INFINITY - 1);
+
+    /* Only a negative w can bring an infinite src[j] below infinity. */
+    if (w < 0) {
+        for (; j + 8 <= n; j += 8) {
+            __m256i d = _mm256_loadu_si256((__m256i const*) (dst + j));
+            __m256i s = _mm256_loadu_si256((__m256i const*) (src + j));
+            __m256i sum = _mm256_blendv_epi8(_mm256_add_epi32(s, weight), s,
+                                             _mm256_cmpgt_epi32(s, infinity));
+            d = _mm256_min_epi32(d, sum);
+            _mm256_storeu_si256((__m256i*) (dst + j), d);
+        }
+    }
+
+    for (; j + 8 <= n; j += 8) {
+        __m256i d = _mm256_loadu_si256((__m256i const*) (dst + j));
+        __m256i s = _mm256_loadu_si256((__m256i const*) (src + j));
+        d = _mm256_min_epi32(d, _mm256_add_epi32(s, weight));
+        _mm256_storeu_si256((__m256i*) (dst + j), d);
+    }
+#endif
+
+    for (; j < n; ++j) {
+        int pathSum = w + src[j];
+        if (dst[j] > pathSum && src[j] < GRAPH_INFINITY) {
+            dst[j] = pathSum;
+        }
+    }
+}
+
+void relaxPivotRows(int** pivotRows, int kb, int ke, int numVertices) {
+    int kw = ke - kb;
+
+    /* Phase 1: plain Floyd-Warshall inside the diagonal tile. */
+    for (int k = 0; k < kw; ++k) {
+        for (int i = 0; i < kw; ++i) {
+            minPlusRow(pivotRows[i] + kb, pivotRows[k] + kb, pivotRows[i][kb + k], kw);
+        }
+    }
+
+    /* Phase 2, pivot rows: tiles left and right of the diagonal one. */
+#pragma omp parallel for schedule(dynamic)
+    for (int jb = 0; jb < numVertices; jb += FW_TILE_SIZE) {
+        if (jb == kb) {
+            continue;
+        }
+        int jw = std::min(FW_TILE_SIZE, numVertices - jb);
+
+        for (int k = 0; k < kw; ++k) {
+            for (int i = 0; i < kw; ++i) {
+                minPlusRow(pivotRows[i] + jb, pivotRows[k] + jb, pivotRows[i][kb + k], jw);
+            }
+        }
+    }
+}
+
+void relaxRowsThroughPivotRows(int** rows, int numRows, int* const* pivotRows, int kb, int ke,
+                               int numVertices) {
+    int kw = ke - kb;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int ib = 0; ib < numRows; ib += FW_TILE_SIZE) {
+        int ie = std::min(ib + FW_TILE_SIZE, numRows);
+
+        /* Phase 2, pivot column: the tile of these rows in columns [kb, ke). */
+        for (int k = 0; k < kw; ++k) {
+            for (int i = ib; i < ie; ++i) {
+                minPlusRow(rows[i] + kb, pivotRows[k] + kb, rows[i][kb + k], kw);
+            }
+        }
+
+        /*
+         * Phase 3: every other tile of these rows. Both factors are final
+         * by now, so this is the min-plus product of the pivot-column
+         * tile and the pivot rows, left and right of the pivot column.
+         */
+        minPlusGemm(rows + ib, 0, rows + ib, kb, pivotRows, 0, ie - ib, kb, kw);
+        minPlusGemm(rows + ib, ke, rows + ib, kb, pivotRows, ke, ie - ib, numVertices - ke, kw);
+    }
+}
+
+void runFloydWarshallBlocked(int** rows, int numVertices) {
+    for (int kb = 0; kb < numVertices; kb += FW_TILE_SIZE) {
+        int ke = std::min(kb + FW_TILE_SIZE, numVertices);
+
+        relaxPivotRows(rows + kb, kb, ke, numVertices);
+        relaxRowsThroughPivotRows(rows, kb, rows + kb, kb, ke, numVertices);
+        relaxRowsThroughPivotRows(rows + ke, numVertices - ke, rows + kb, kb, ke, numVertices);
+    }
+}
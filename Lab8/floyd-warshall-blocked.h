@@ -0,0 +1,46 @@
+/*
+ * Three-phase blocked (tiled) Floyd-Warshall kernel.
+ */
+
+#ifndef __MY_FLOYD_WARSHALL_BLOCKED__H__
+#define __MY_FLOYD_WARSHALL_BLOCKED__H__
+
+/**
+ * Edge of a tile. Three 64 x 64 int tiles (48 KiB)
+ * fit in L2 next to the rows of the pivot panel.
+ */
+#define FW_TILE_SIZE 64
+
+/**
+ * The min-plus inner loop: dst[j] = min(dst[j], w + src[j])
+ * for j in [0, n), skipping sums with a term at or above
+ * GRAPH_INFINITY. Uses AVX2 vpminsd when available.
+ */
+void minPlusRow(int *dst, int const *src, int w, int n);
+
+/**
+ * Phases 1 and 2 (pivot row part) for the pivot block
+ * of rows [kb, ke): the diagonal tile is solved first,
+ * then every other tile of the pivot rows is relaxed
+ * through it. pivotRows[r] is the full row kb + r.
+ */
+void relaxPivotRows(int **pivotRows, int kb, int ke, int numVertices);
+
+/**
+ * Phase 2 (pivot column part) and phase 3 for rows
+ * outside of the pivot block: the pivot-column tile of
+ * every row is relaxed through the diagonal tile, then
+ * all remaining tiles through the pivot rows with
+ * minPlusGemm. Row tiles are processed by OpenMP threads.
+ */
+void relaxRowsThroughPivotRows(int **rows, int numRows,
+                               int *const *pivotRows, int kb, int ke,
+                               int numVertices);
+
+/**
+ * Runs the blocked Floyd-Warshall algorithm on
+ * an entire numVertices x numVertices matrix.
+ */
+void runFloydWarshallBlocked(int **rows, int numVertices);
+
+#endif /* __MY_FLOYD_WARSHALL_BLOCKED__H__ */
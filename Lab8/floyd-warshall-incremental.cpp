@@ -0,0 +1,93 @@
+/*
+ * Incremental all-pairs shortest paths: updating a computed
+ * distance matrix after edge weights decrease.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <mpi.h>
+#include "floyd-warshall-blocked.h"
+#include "floyd-warshall-incremental.h"
+#include "graph-base.h"
+
+/*
+ * Detours of at least INT_MAX / 2 cannot improve on the "no edge"
+ * weights (at most INT_MAX / 2) and could overflow in the kernel.
+ */
+static inline bool isUsefulDetour(int distToFrom, int weight) {
+    return (long long) distToFrom + weight < INT_MAX / 2;
+}
+
+int decreaseEdgeWeight(Graph* graph, int u, int v, int w, int numProcesses, int myRank) {
+    return decreaseEdgeWeights(graph, std::vector<EdgeUpdate>(1, EdgeUpdate{u, v, w}),
+                               numProcesses, myRank);
+}
+
+int decreaseEdgeWeights(Graph* graph, std::vector<EdgeUpdate> const& updates, int numProcesses,
+                        int myRank) {
+    assert(numProcesses >= 1 && myRank >= 0 && myRank < numProcesses);
+    int m = graph->numVertices;
+    int low = graph->firstRowIdxIncl;
+    int high = graph->lastRowIdxExcl;
+
+    /* Every process has the same updates, so all of them return here or none. */
+    for (auto const& update : updates) {
+        if (update.from < 0 || update.from >= m || update.to < 0 || update.to >= m) {
+            return 1;
+        }
+    }
+
+    /* Rows of distinct targets, ascending, which is also the order of their owners. */
+    std::vector<int> targets;
+    for (auto const& update : updates) {
+        targets.push_back(update.to);
+    }
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+    int numTargets = (int) targets.size();
+    std::vector<int> recvCounts(numProcesses, 0);
+    std::vector<int> recvDispls(numProcesses, 0);
+    std::vector<int> sendRows;
+
+    for (int t = 0; t < numTargets; ++t) {
+        int owner = getProcessOfElement(targets[t], m, numProcesses);
+        recvCounts[owner] += m;
+        if (owner == myRank) {
+            sendRows.insert(sendRows.end(), graph->data[targets[t] - low],
+                            graph->data[targets[t] - low] + m);
+        }
+    }
+    for (int p = 1; p < numProcesses; ++p) {
+        recvDispls[p] = recvDispls[p - 1] + recvCounts[p - 1];
+    }
+
+    std::vector<int> targetRows((size_t) numTargets * m);
+    MPI_Allgatherv(sendRows.data(), (int) sendRows.size(), MPI_INT, targetRows.data(),
+                   recvCounts.data(), recvDispls.data(), MPI_INT, MPI_COMM_WORLD);
+
+    for (auto const& update : updates) {
+        int t = (int) (std::lower_bound(targets.begin(), targets.end(), update.to) -
+                       targets.begin());
+        int const* rowV = targetRows.data() + (size_t) t * m;
+
+        /* The copies are rows of the matrix as well, except for row v itself. */
+        for (int s = 0; s < numTargets; ++s) {
+            int* copy = targetRows.data() + (size_t) s * m;
+            if (s != t && isUsefulDetour(copy[update.from], update.weight)) {
+                minPlusRow(copy, rowV, copy[update.from] + update.weight, m);
+            }
+        }
+
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < high - low; ++i) {
+            int* row = graph->data[i];
+            if (i + low != update.to && isUsefulDetour(row[update.from], update.weight)) {
+                minPlusRow(row, rowV, row[update.from] + update.weight, m);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * Incremental all-pairs shortest paths: updating a computed
+ * distance matrix after edge weights decrease.
+ */
+
+#ifndef __MY_FLOYD_WARSHALL_INCREMENTAL__H__
+#define __MY_FLOYD_WARSHALL_INCREMENTAL__H__
+
+#include <vector>
+#include "graph-base.h"
+
+/**
+ * A new, lower weight of the edge from -> to.
+ */
+class EdgeUpdate {
+public:
+  int from;
+  int to;
+  int weight;
+};
+
+/**
+ * Updates a distributed distance matrix after the
+ * edge u -> v drops to weight w: every process relaxes
+ * its rows with d[i][j] = min(d[i][j], d[i][u] + w + d[v][j]),
+ * which takes O(numVertices^2 / p) work and a broadcast
+ * of row v. Must be called by all processes.
+ * Returns 0 on success and 1, leaving the distances
+ * unchanged, if u or v is not a vertex of the graph.
+ */
+int decreaseEdgeWeight(Graph *graph, int u, int v, int w, int numProcesses,
+                        int myRank);
+
+/**
+ * Applies a batch of decreases in order, with the same
+ * result as calling decreaseEdgeWeight for each of them.
+ * The distinct target rows are gathered in one
+ * MPI_Allgatherv; the gathered copies are then kept up to
+ * date locally, so the batch needs no further messages.
+ * Returns 0 on success and 1, leaving the distances
+ * unchanged, if any update names a vertex outside the graph.
+ */
+int decreaseEdgeWeights(Graph *graph, std::vector<EdgeUpdate> const &updates,
+                         int numProcesses, int myRank);
+
+#endif /* __MY_FLOYD_WARSHALL_INCREMENTAL__H__ */
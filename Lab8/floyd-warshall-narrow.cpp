@@ -0,0 +1,142 @@
+/*
+ * Floyd-Warshall over narrow unsigned distances
+ * with saturating arithmetic.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <limits>
+#include <mpi.h>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "floyd-warshall-narrow.h"
+#include "graph-base.h"
+
+/* a + b, saturated at the largest T: a + min(b, ~a) cannot overflow. */
+template <typename T>
+static inline T saturatingAdd(T a, T b) {
+    return a + std::min(b, T(~a));
+}
+
+template <>
+void minPlusRowSaturating<uint16_t>(uint16_t* dst, uint16_t const* src, uint16_t w, int n) {
+    int j = 0;
+
+#ifdef __AVX2__
+    __m256i weight = _mm256_set1_epi16((short) w);
+
+    for (; j + 16 <= n; j += 16) {
+        __m256i d = _mm256_loadu_si256((__m256i const*) (dst + j));
+        __m256i s = _mm256_loadu_si256((__m256i const*) (src + j));
+        d = _mm256_min_epu16(d, _mm256_adds_epu16(s, weight));
+        _mm256_storeu_si256((__m256i*) (dst + j), d);
+    }
+#endif
+
+    for (; j < n; ++j) {
+        dst[j] = std::min(dst[j], saturatingAdd(w, src[j]));
+    }
+}
+
+template <>
+void minPlusRowSaturating<uint32_t>(uint32_t* dst, uint32_t const* src, uint32_t w, int n) {
+    int j = 0;
+
+#ifdef __AVX2__
+    /* There is no vpaddusd: w + min(s, ~w) saturates instead. */
+    __m256i weight = _mm256_set1_epi32((int) w);
+    __m256i headroom = _mm256_set1_epi32((int) ~w);
+
+    for (; j + 8 <= n; j += 8) {
+        __m256i d = _mm256_loadu_si256((__m256i const*) (dst + j));
+        __m256i s = _mm256_loadu_si256((__m256i const*) (src + j));
+        s = _mm256_add_epi32(weight, _mm256_min_epu32(s, headroom));
+        _mm256_storeu_si256((__m256i*) (dst + j), _mm256_min_epu32(d, s));
+    }
+#endif
+
+    for (; j < n; ++j) {
+        dst[j] = std::min(dst[j], saturatingAdd(w, src[j]));
+    }
+}
+
+template <typename T>
+static void runFloydWarshallNarrowTyped(Graph* graph, int noEdgeWeight, int numProcesses,
+                                        int myRank, MPI_Datatype type) {
+    T const inf = std::numeric_limits<T>::max();
+    int m = graph->numVertices;
+    int low = graph->firstRowIdxIncl;
+    int high = graph->lastRowIdxExcl;
+    std::vector<T> rows((size_t) (high - low) * m);
+    std::vector<T> pivotRow(m);
+
+    for (int i = 0; i < high - low; ++i) {
+        for (int j = 0; j < m; ++j) {
+            int d = graph->data[i][j];
+            rows[(size_t) i * m + j] = d >= noEdgeWeight ? inf : (T) d;
+        }
+    }
+
+    for (int k = 0; k < m; ++k) {
+        int root = getProcessOfElement(k, m, numProcesses);
+        if (myRank == root) {
+            std::copy(&rows[(size_t) (k - low) * m], &rows[(size_t) (k - low) * m] + m,
+                      pivotRow.begin());
+        }
+        MPI_Bcast(pivotRow.data(), m, type, root, MPI_COMM_WORLD);
+
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < high - low; ++i) {
+            T* row = &rows[(size_t) i * m];
+            /* Nothing can be improved through an unreachable pivot. */
+            if (row[k] != inf) {
+                minPlusRowSaturating(row, pivotRow.data(), row[k], m);
+            }
+        }
+    }
+
+    for (int i = 0; i < high - low; ++i) {
+        for (int j = 0; j < m; ++j) {
+            T d = rows[(size_t) i * m + j];
+            graph->data[i][j] = d == inf ? noEdgeWeight : (int) d;
+        }
+    }
+}
+
+int runFloydWarshallNarrow(Graph* graph, int noEdgeWeight, int numProcesses, int myRank) {
+    assert(numProcesses <= graph->numVertices);
+    int m = graph->numVertices;
+    long long bounds[2] = {0, 0}; /* {largest weight, -smallest weight} */
+
+    for (int i = 0; i < graph->lastRowIdxExcl - graph->firstRowIdxIncl; ++i) {
+        for (int j = 0; j < m; ++j) {
+            int d = graph->data[i][j];
+            if (d < noEdgeWeight) {
+                bounds[0] = std::max(bounds[0], (long long) d);
+                bounds[1] = std::max(bounds[1], -(long long) d);
+            }
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, bounds, 2, MPI_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+    /* The longest simple path has m - 1 edges; it must stay below INF. */
+    long long longestPath = (long long) (m - 1) * bounds[0];
+
+    if (bounds[1] > 0) {
+        return 0;
+    } else if (longestPath < UINT16_MAX) {
+        runFloydWarshallNarrowTyped<uint16_t>(graph, noEdgeWeight, numProcesses, myRank,
+                                              MPI_UINT16_T);
+        return sizeof(uint16_t);
+    } else if (longestPath < INT_MAX) {
+        /* INT_MAX rather than UINT32_MAX, so that the results fit in Graph::data. */
+        runFloydWarshallNarrowTyped<uint32_t>(graph, noEdgeWeight, numProcesses, myRank,
+                                              MPI_UINT32_T);
+        return sizeof(uint32_t);
+    } else {
+        return 0;
+    }
+}
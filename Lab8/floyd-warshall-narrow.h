@@ -0,0 +1,45 @@
+/*
+ * Floyd-Warshall over narrow unsigned distances
+ * with saturating arithmetic.
+ */
+
+#ifndef __MY_FLOYD_WARSHALL_NARROW__H__
+#define __MY_FLOYD_WARSHALL_NARROW__H__
+
+#include <stdint.h>
+#include "graph-base.h"
+
+/**
+ * The saturating min-plus inner loop over unsigned
+ * distances: dst[j] = min(dst[j], w (+) src[j]) for j in
+ * [0, n), where (+) saturates at the largest value of T,
+ * which stands for infinity: INF (+) x = INF for any x.
+ * Instantiated for uint16_t (vpaddusw) and uint32_t.
+ */
+template <typename T>
+void minPlusRowSaturating(T *dst, T const *src, T w, int n);
+
+template <>
+void minPlusRowSaturating<uint16_t>(uint16_t *dst, uint16_t const *src,
+                                    uint16_t w, int n);
+
+template <>
+void minPlusRowSaturating<uint32_t>(uint32_t *dst, uint32_t const *src,
+                                    uint32_t w, int n);
+
+/**
+ * Runs Floyd-Warshall on a distributed graph in the
+ * narrowest unsigned type that can hold every finite
+ * path length, (numVertices - 1) times the largest weight,
+ * below its INF sentinel. Weights equal to or greater than
+ * noEdgeWeight become INF, and INF becomes noEdgeWeight
+ * again at the end. Pivot rows are broadcast in the narrow
+ * type too. Returns the number of bytes per distance, or 0
+ * (leaving graph untouched) if the weights do not fit,
+ * e.g. because some are negative. Must be called by all
+ * processes.
+ */
+int runFloydWarshallNarrow(Graph *graph, int noEdgeWeight, int numProcesses,
+                           int myRank);
+
+#endif /* __MY_FLOYD_WARSHALL_NARROW__H__ */
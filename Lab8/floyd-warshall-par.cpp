@@ -4,53 +4,181 @@
  * Refactoring 2019, Łukasz Rączkowski
  */
 
+#include "floyd-warshall-blocked.h"
+#include "floyd-warshall-incremental.h"
+#include "floyd-warshall-narrow.h"
+#include "floyd-warshall-paths.h"
+#include "floyd-warshall-squaring.h"
 #include "graph-base.h"
+#include "graph-io.h"
+#include "graph-sparse.h"
 #include "graph-utils.h"
 #include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <mpi.h>
+#include <omp.h>
 #include <string>
-int getProcessOfElement(int k, int numVertices, int numProcesses) {
-  int base = numVertices / numProcesses;
-  int extra = numVertices % numProcesses;
-  int threshold = (base + 1) * extra;
+#include <vector>
 
-  if (k < threshold) {
-    return k / (base + 1);
+/* Rows relaxed between two MPI_Test calls in the look-ahead mode. */
+#define LOOK_AHEAD_TEST_INTERVAL 16
+
+static inline void relaxRow(int *row, int k, const int *pivotRow, int m) {
+  if (row[k] >= GRAPH_INFINITY) {
+    return;
+  }
+  for (int j = 0; j < m; ++j) {
+    int pathSum = row[k] + pivotRow[j];
+    if (row[j] > pathSum && pivotRow[j] < GRAPH_INFINITY) {
+      row[j] = pathSum;
+    }
+  }
+}
+
+/* Records successors as well when path reconstruction is on (next != nullptr). */
+static inline void relaxLocalRow(Graph *graph, Successors *next, int i, int k,
+                                 const int *pivotRow) {
+  if (next != nullptr) {
+    relaxRowWithSuccessors(graph, next, i, k, pivotRow);
   } else {
-    return extra + (k - threshold) / base;
+    relaxRow(graph->data[i], k, pivotRow, graph->numVertices);
   }
 }
 
-static void runFloydWarshallParallel(Graph *graph, int numProcesses,
-                                     int myRank) {
+static void runFloydWarshallParallel(Graph *graph, Successors *successors,
+                                     int numProcesses, int myRank) {
   assert(numProcesses <= graph->numVertices);
   int m = graph->numVertices;
   int *buffer;
   buffer = new int[m];
   int low = graph->firstRowIdxIncl;
   int high = graph->lastRowIdxExcl;
-  int base = graph->numVertices / numProcesses;
   int root = 0;
-  int jump = base;
-  int thres = jump;
   for (int k = 0; k < m; ++k) {
     root = getProcessOfElement(k, m, numProcesses);
     if (myRank == root) {
       std::copy(graph->data[k - low], graph->data[k - low] + m, buffer);
     }
     MPI_Bcast(buffer, m, MPI_INT, root, MPI_COMM_WORLD);
+#pragma omp parallel for schedule(static)
     for (int i = 0; i < high - low; ++i) {
-      for (int j = 0; j < m; ++j) {
-        int pathSum = graph->data[i][k] + buffer[j];
-        if (graph->data[i][j] > pathSum) {
-          graph->data[i][j] = pathSum;
+      relaxLocalRow(graph, successors, i, k, buffer);
+    }
+  }
+  delete[] buffer;
+}
+
+/*
+ * Look-ahead variant: while the ranks relax their rows for pivot k,
+ * row k + 1 is already on its way. Its owner relaxes that row first
+ * and starts an MPI_Ibcast of it before touching the rest of its block.
+ */
+static void runFloydWarshallLookAhead(Graph *graph, Successors *successors,
+                                      int numProcesses, int myRank) {
+  assert(numProcesses <= graph->numVertices);
+  int m = graph->numVertices;
+  int *buffers[2] = {new int[m], new int[m]};
+  int low = graph->firstRowIdxIncl;
+  int high = graph->lastRowIdxExcl;
+  MPI_Request request;
+
+  int root = getProcessOfElement(0, m, numProcesses);
+  if (myRank == root) {
+    std::copy(graph->data[0 - low], graph->data[0 - low] + m, buffers[0]);
+  }
+  MPI_Ibcast(buffers[0], m, MPI_INT, root, MPI_COMM_WORLD, &request);
+
+  for (int k = 0; k < m; ++k) {
+    int *pivotRow = buffers[k % 2];
+    MPI_Wait(&request, MPI_STATUS_IGNORE);
+
+    int next = k + 1;
+    bool nextIsMine = next < m && next >= low && next < high;
+    if (next < m) {
+      int nextRoot = getProcessOfElement(next, m, numProcesses);
+      if (myRank == nextRoot) {
+        relaxLocalRow(graph, successors, next - low, k, pivotRow);
+        std::copy(graph->data[next - low], graph->data[next - low] + m,
+                  buffers[next % 2]);
+      }
+      MPI_Ibcast(buffers[next % 2], m, MPI_INT, nextRoot, MPI_COMM_WORLD,
+                 &request);
+    }
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < high - low; ++i) {
+      if (nextIsMine && i == next - low) {
+        continue;
+      }
+      relaxLocalRow(graph, successors, i, k, pivotRow);
+      /*
+       * Lets the library progress the broadcast in flight; only
+       * the master thread talks to MPI (MPI_THREAD_FUNNELED).
+       */
+      if (next < m && i % LOOK_AHEAD_TEST_INTERVAL == 0 &&
+          omp_get_thread_num() == 0) {
+        int done;
+        MPI_Test(&request, &done, MPI_STATUS_IGNORE);
+      }
+    }
+  }
+  delete[] buffers[0];
+  delete[] buffers[1];
+}
+
+/*
+ * Blocked variant: the owners of the FW_TILE_SIZE pivot rows of a
+ * k-block broadcast them, every rank runs phases 1 and 2 on that
+ * panel itself, and then relaxes its own rows with the blocked kernel.
+ */
+static void runFloydWarshallBlockedParallel(Graph *graph, int numProcesses,
+                                            int myRank) {
+  assert(numProcesses <= graph->numVertices);
+  int m = graph->numVertices;
+  int low = graph->firstRowIdxIncl;
+  int high = graph->lastRowIdxExcl;
+  int *panel = new int[(size_t)FW_TILE_SIZE * m];
+  int *pivotRows[FW_TILE_SIZE];
+
+  for (int r = 0; r < FW_TILE_SIZE; ++r) {
+    pivotRows[r] = panel + (size_t)r * m;
+  }
+
+  for (int kb = 0; kb < m; kb += FW_TILE_SIZE) {
+    int ke = std::min(kb + FW_TILE_SIZE, m);
+
+    /* The pivot rows may be split between several consecutive ranks. */
+    for (int first = kb; first < ke;) {
+      int root = getProcessOfElement(first, m, numProcesses);
+      int last = std::min(
+          ke, getFirstGraphRowOfProcess(m, numProcesses, root + 1));
+      if (myRank == root) {
+        for (int i = first; i < last; ++i) {
+          std::copy(graph->data[i - low], graph->data[i - low] + m,
+                    pivotRows[i - kb]);
         }
       }
+      MPI_Bcast(pivotRows[first - kb], (last - first) * m, MPI_INT, root,
+                MPI_COMM_WORLD);
+      first = last;
+    }
+
+    relaxPivotRows(pivotRows, kb, ke, m);
+
+    int beforeEnd = std::min(std::max(kb, low), high);
+    int afterStart = std::min(std::max(ke, low), high);
+    relaxRowsThroughPivotRows(graph->data, beforeEnd - low, pivotRows, kb, ke,
+                              m);
+    relaxRowsThroughPivotRows(graph->data + (afterStart - low),
+                              high - afterStart, pivotRows, kb, ke, m);
+
+    for (int i = beforeEnd; i < afterStart; ++i) {
+      std::copy(pivotRows[i - kb], pivotRows[i - kb] + m,
+                graph->data[i - low]);
     }
   }
-  delete[] buffer;
+  delete[] panel;
 }
 
 int main(int argc, char *argv[]) {
@@ -58,70 +186,240 @@ int main(int argc, char *argv[]) {
   int numProcesses = 0;
   int myRank = 0;
   int showResults = 0;
+  int lookAhead = 0;
+  int blocked = 0;
+  int johnson = 0;
+  int narrow = 0;
+  int squaring = 0;
+  int autoSelect = 0;
+  int threadSupport = 0;
+  char const *inputPath = nullptr;
+  char const *edgeListPath = nullptr;
+  char const *outputPath = nullptr;
+  std::vector<int> pathFrom;
+  std::vector<int> pathTo;
+  std::vector<EdgeUpdate> decreases;
 
-  MPI_Init(&argc, &argv);
+  /*
+   * Hybrid mode: run one rank per node (or socket) with OMP_NUM_THREADS
+   * threads relaxing its rows; MPI calls stay on the master thread.
+   */
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threadSupport);
   MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
   MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
 
-#ifdef USE_RANDOM_GRAPH
-#ifdef USE_RANDOM_SEED
-  srand(USE_RANDOM_SEED);
-#endif
-#endif
+  if (threadSupport < MPI_THREAD_FUNNELED) {
+    if (myRank == 0) {
+      std::cerr << "MPI_THREAD_FUNNELED is not supported, using 1 thread."
+                << std::endl;
+    }
+    omp_set_num_threads(1);
+  }
 
   for (int i = 1; i < argc; ++i) {
     if (std::string(argv[i]).compare("--show-results") == 0) {
       showResults = 1;
+    } else if (std::string(argv[i]).compare("--look-ahead") == 0) {
+      lookAhead = 1;
+    } else if (std::string(argv[i]).compare("--blocked") == 0) {
+      blocked = 1;
+    } else if (std::string(argv[i]).compare("--narrow") == 0) {
+      narrow = 1;
+    } else if (std::string(argv[i]).compare("--squaring") == 0) {
+      squaring = 1;
+    } else if (std::string(argv[i]).compare("--johnson") == 0) {
+      johnson = 1;
+    } else if (std::string(argv[i]).compare("--auto") == 0) {
+      autoSelect = 1;
+    } else if (std::string(argv[i]).compare("--path") == 0 && i + 2 < argc) {
+      pathFrom.push_back(std::stoi(argv[++i]));
+      pathTo.push_back(std::stoi(argv[++i]));
+    } else if (std::string(argv[i]).compare("--decrease") == 0 &&
+               i + 3 < argc) {
+      int from = std::stoi(argv[++i]);
+      int to = std::stoi(argv[++i]);
+      decreases.push_back(EdgeUpdate{from, to, std::stoi(argv[++i])});
+    } else if (std::string(argv[i]).compare("--input") == 0 && i + 1 < argc) {
+      inputPath = argv[++i];
+    } else if (std::string(argv[i]).compare("--edge-list") == 0 &&
+               i + 1 < argc) {
+      edgeListPath = argv[++i];
+    } else if (std::string(argv[i]).compare("--output") == 0 && i + 1 < argc) {
+      outputPath = argv[++i];
     } else {
       numVertices = std::stoi(argv[i]);
     }
   }
 
-  if (numVertices <= 0) {
-    std::cerr << "Usage: " << argv[0] << "  [--show-results] <num_vertices>"
+  if ((numVertices <= 0 && inputPath == nullptr && edgeListPath == nullptr) ||
+      (!pathFrom.empty() &&
+       (blocked || narrow || squaring || johnson || autoSelect ||
+        !decreases.empty()))) {
+    std::cerr << "Usage: " << argv[0]
+              << "  [--show-results]"
+              << " [--look-ahead | --blocked | --narrow | --squaring | --johnson"
+              << " | --auto]"
+              << " [--output <file>] [--path <from> <to>]..."
+              << " [--decrease <from> <to> <weight>]..."
+              << " (<num_vertices> | --input <file> | --edge-list <file>)"
               << std::endl;
     MPI_Finalize();
     return 1;
   }
 
-  if (numProcesses > numVertices) {
-    numProcesses = numVertices;
+  Graph *graph = nullptr;
+  int noEdgeWeight = GRAPH_IO_INFINITY;
 
-    if (myRank >= numProcesses) {
+  if (inputPath != nullptr || edgeListPath != nullptr) {
+    /* Loaded graphs are expected to have more vertices than processes. */
+    graph = inputPath != nullptr
+                ? readGraphFile(inputPath, numProcesses, myRank)
+                : readEdgeListFile(edgeListPath, numProcesses, myRank);
+    if (graph == nullptr) {
+      if (myRank == 0) {
+        std::cerr << "Error reading the graph from "
+                  << (inputPath != nullptr ? inputPath : edgeListPath) << "."
+                  << std::endl;
+      }
       MPI_Finalize();
-      return 0;
+      return 2;
     }
-  }
+    numVertices = graph->numVertices;
+  } else {
+    if (numProcesses > numVertices) {
+      numProcesses = numVertices;
 
-  std::cerr << "Running the Floyd-Warshall algorithm for a graph with "
-            << numVertices << " vertices." << std::endl;
+      if (myRank >= numProcesses) {
+        MPI_Finalize();
+        return 0;
+      }
+    }
 
-  auto graph = createAndDistributeGraph(numVertices, numProcesses, myRank);
-  if (graph == nullptr) {
-    std::cerr << "Error distributing the graph for the algorithm." << std::endl;
-    MPI_Finalize();
-    return 2;
+    noEdgeWeight = getGraphNoEdgeWeight(numVertices);
+    graph = createAndDistributeGraph(numVertices, numProcesses, myRank);
+    if (graph == nullptr) {
+      std::cerr << "Error distributing the graph for the algorithm."
+                << std::endl;
+      MPI_Finalize();
+      return 2;
+    }
   }
 
+  /* Rejected before the algorithm runs rather than by decreaseEdgeWeights. */
+  for (auto const &update : decreases) {
+    if (update.from < 0 || update.from >= numVertices || update.to < 0 ||
+        update.to >= numVertices) {
+      if (myRank == 0) {
+        std::cerr << "Invalid vertex pair " << update.from << " " << update.to
+                  << "." << std::endl;
+      }
+      destroyGraph(graph, numProcesses, myRank);
+      MPI_Finalize();
+      return 1;
+    }
+  }
+
+  std::cerr << "Running the Floyd-Warshall algorithm for a graph with "
+            << numVertices << " vertices on " << omp_get_max_threads()
+            << " thread(s)." << std::endl;
+
   if (showResults) {
     collectAndPrintGraph(graph, numProcesses, myRank);
   }
 
+  /* Paths are tracked only by the row-by-row variants. */
+  Successors *successors = nullptr;
+  if (!pathFrom.empty()) {
+    successors = createSuccessors(graph, noEdgeWeight);
+  }
+
   double startTime = MPI_Wtime();
 
-  runFloydWarshallParallel(graph, numProcesses, myRank);
+  /* Deciding needs only the number of edges; the CSR is built if used. */
+  if (autoSelect && !johnson) {
+    johnson = isJohnsonPreferable(graph->numVertices,
+                                  countEdges(graph, noEdgeWeight));
+  }
+
+  /* Johnson's algorithm needs the whole graph, in CSR, at every process. */
+  SparseGraph *sparse = nullptr;
+  if (johnson) {
+    sparse = createSparseGraph(graph, noEdgeWeight, numProcesses, myRank);
+  }
+
+  if (johnson) {
+    if (runJohnson(graph, sparse, noEdgeWeight) != 0) {
+      if (myRank == 0) {
+        std::cerr << "The graph has a negative cycle." << std::endl;
+      }
+      destroySparseGraph(sparse);
+      destroyGraph(graph, numProcesses, myRank);
+      MPI_Finalize();
+      return 3;
+    }
+  } else if (blocked) {
+    runFloydWarshallBlockedParallel(graph, numProcesses, myRank);
+  } else if (narrow) {
+    int bytes = runFloydWarshallNarrow(graph, noEdgeWeight, numProcesses, myRank);
+    if (bytes == 0) {
+      runFloydWarshallParallel(graph, nullptr, numProcesses, myRank);
+    }
+    if (myRank == 0) {
+      std::cerr << "Distances were stored in "
+                << (bytes == 0 ? (int)sizeof(int) : bytes) << " byte(s)."
+                << std::endl;
+    }
+  } else if (squaring) {
+    int squarings = runMinPlusSquaring(graph, numProcesses);
+    if (myRank == 0) {
+      std::cerr << "Distances converged after " << squarings
+                << " squaring(s)." << std::endl;
+    }
+  } else if (lookAhead) {
+    runFloydWarshallLookAhead(graph, successors, numProcesses, myRank);
+  } else {
+    runFloydWarshallParallel(graph, successors, numProcesses, myRank);
+  }
+  destroySparseGraph(sparse);
 
   double endTime = MPI_Wtime();
   if (myRank == 0) {
-    std::cerr << "The time required for the Floyd-Warshall algorithm on a "
-              << numVertices << "-node graph with " << numProcesses
-              << " process(es): " << endTime - startTime << std::endl;
+    std::cerr << "The time required for the "
+              << (johnson ? "Johnson" : "Floyd-Warshall")
+              << " algorithm on a " << numVertices << "-node graph with "
+              << numProcesses << " process(es): " << endTime - startTime
+              << std::endl;
+  }
+
+  /* The successors are not maintained by the incremental update. */
+  if (!decreases.empty()) {
+    startTime = MPI_Wtime();
+    decreaseEdgeWeights(graph, decreases, numProcesses, myRank);
+    endTime = MPI_Wtime();
+    if (myRank == 0) {
+      std::cerr << "The time required for " << decreases.size()
+                << " incremental edge update(s) with " << numProcesses
+                << " process(es): " << endTime - startTime << std::endl;
+    }
   }
+
   MPI_Barrier(MPI_COMM_WORLD);
   if (showResults) {
     collectAndPrintGraph(graph, numProcesses, myRank);
   }
 
+  if (successors != nullptr) {
+    printPaths(graph, successors, pathFrom, pathTo, numProcesses, myRank);
+    destroySuccessors(successors);
+  }
+
+  if (outputPath != nullptr &&
+      writeGraphFile(graph, outputPath, numProcesses, myRank) != 0 &&
+      myRank == 0) {
+    std::cerr << "Error writing the graph to " << outputPath << "."
+              << std::endl;
+  }
+
   destroyGraph(graph, numProcesses, myRank);
 
   MPI_Finalize();
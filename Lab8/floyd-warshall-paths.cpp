@@ -0,0 +1,240 @@
+/*
+ * Path reconstruction for Floyd-Warshall: a successor
+ * (next-hop) matrix updated together with the distances.
+ */
+
+#include <cassert>
+#include <iostream>
+#include <mpi.h>
+#include <stdint.h>
+#include <string.h>
+#include "floyd-warshall-paths.h"
+#include "graph-base.h"
+
+static uint32_t getNoSuccessor(int elementBytes) {
+    return elementBytes == 4 ? UINT32_MAX : (1u << (8 * elementBytes)) - 1;
+}
+
+static uint32_t readSuccessor(void const* base, size_t idx, int elementBytes) {
+    switch (elementBytes) {
+        case 1:
+            return static_cast<uint8_t const*>(base)[idx];
+        case 2:
+            return static_cast<uint16_t const*>(base)[idx];
+        default:
+            return static_cast<uint32_t const*>(base)[idx];
+    }
+}
+
+template <typename T>
+static void initializeSuccessorRow(T* next, int const* row, int rowIdx, int numVertices,
+                                   int noEdgeWeight) {
+    T none = (T) getNoSuccessor(sizeof(T));
+
+    for (int j = 0; j < numVertices; ++j) {
+        next[j] = (j == rowIdx || row[j] < noEdgeWeight) ? (T) j : none;
+    }
+}
+
+Successors* createSuccessors(Graph* graph, int noEdgeWeight) {
+    int numVertices = graph->numVertices;
+    int numLocalRows = graph->lastRowIdxExcl - graph->firstRowIdxIncl;
+    auto next = new Successors;
+
+    /* The largest value of the type is reserved for "no path". */
+    next->elementBytes = numVertices < (1 << 8) ? 1 : numVertices < (1 << 16) ? 2 : 4;
+    next->numVertices = numVertices;
+    next->firstRowIdxIncl = graph->firstRowIdxIncl;
+    next->lastRowIdxExcl = graph->lastRowIdxExcl;
+    next->data = new uint32_t[((size_t) numLocalRows * numVertices * next->elementBytes + 3) / 4];
+
+    for (int i = 0; i < numLocalRows; ++i) {
+        size_t offset = (size_t) i * numVertices;
+        int rowIdx = graph->firstRowIdxIncl + i;
+
+        switch (next->elementBytes) {
+            case 1:
+                initializeSuccessorRow(static_cast<uint8_t*>(next->data) + offset,
+                                       graph->data[i], rowIdx, numVertices, noEdgeWeight);
+                break;
+            case 2:
+                initializeSuccessorRow(static_cast<uint16_t*>(next->data) + offset,
+                                       graph->data[i], rowIdx, numVertices, noEdgeWeight);
+                break;
+            default:
+                initializeSuccessorRow(static_cast<uint32_t*>(next->data) + offset,
+                                       graph->data[i], rowIdx, numVertices, noEdgeWeight);
+                break;
+        }
+    }
+
+    return next;
+}
+
+/*
+ * Branch-free: the comparison mask selects both the new distance
+ * and the new successor, so the loop vectorizes for any T.
+ */
+template <typename T>
+static void relaxTrackedRow(int* row, T* next, int k, int const* pivotRow, int numVertices) {
+    int distToPivot = row[k];
+    T hop = next[k];
+
+    if (distToPivot >= GRAPH_INFINITY) {
+        return;
+    }
+
+#pragma omp simd
+    for (int j = 0; j < numVertices; ++j) {
+        int pathSum = distToPivot + pivotRow[j];
+        bool better = pathSum < row[j] && pivotRow[j] < GRAPH_INFINITY;
+        row[j] = better ? pathSum : row[j];
+        next[j] = better ? hop : next[j];
+    }
+}
+
+void relaxRowWithSuccessors(Graph* graph, Successors* next, int localRow, int k,
+                            int const* pivotRow) {
+    int numVertices = graph->numVertices;
+    size_t offset = (size_t) localRow * numVertices;
+
+    switch (next->elementBytes) {
+        case 1:
+            relaxTrackedRow(graph->data[localRow], static_cast<uint8_t*>(next->data) + offset, k,
+                            pivotRow, numVertices);
+            break;
+        case 2:
+            relaxTrackedRow(graph->data[localRow], static_cast<uint16_t*>(next->data) + offset, k,
+                            pivotRow, numVertices);
+            break;
+        default:
+            relaxTrackedRow(graph->data[localRow], static_cast<uint32_t*>(next->data) + offset, k,
+                            pivotRow, numVertices);
+            break;
+    }
+}
+
+/* Reads elementBytes bytes at a displacement of a window, locally or with MPI_Get. */
+static void fetchFromWindow(MPI_Win window, void const* localBase, int owner, int myRank,
+                            MPI_Aint disp, int elementBytes, void* value) {
+    if (owner == myRank) {
+        memcpy(value, static_cast<char const*>(localBase) + disp * elementBytes, elementBytes);
+    } else {
+        MPI_Win_lock(MPI_LOCK_SHARED, owner, 0, window);
+        MPI_Get(value, elementBytes, MPI_BYTE, owner, disp, elementBytes, MPI_BYTE, window);
+        MPI_Win_unlock(owner, window);
+    }
+}
+
+std::vector<int> getPath(Graph* graph, Successors* next, int from, int to, int* length,
+                         int numProcesses, int myRank) {
+    int numVertices = graph->numVertices;
+    int numLocalRows = graph->lastRowIdxExcl - graph->firstRowIdxIncl;
+    int elementBytes = next->elementBytes;
+    MPI_Win nextWindow = MPI_WIN_NULL;
+    MPI_Win distWindow = MPI_WIN_NULL;
+    std::vector<int> path;
+    int distance = 0;
+
+    /* Every process sees the same arguments, so all of them return here or none. */
+    if (from < 0 || from >= numVertices || to < 0 || to >= numVertices) {
+        return path;
+    }
+
+    /* A single process reads everything locally and needs no windows. */
+    if (numProcesses > 1) {
+        MPI_Win_create(next->data, (MPI_Aint) numLocalRows * numVertices * elementBytes,
+                       elementBytes, MPI_INFO_NULL, MPI_COMM_WORLD, &nextWindow);
+        MPI_Win_create(graph->storage, (MPI_Aint) numLocalRows * graph->rowStride * sizeof(int),
+                       sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &distWindow);
+    }
+
+    if (myRank == 0) {
+        int u = from;
+        path.push_back(u);
+        while (u != to && (int) path.size() <= numVertices) {
+            unsigned char entry[4];
+            int owner = getProcessOfElement(u, numVertices, numProcesses);
+            int ownerLow = getFirstGraphRowOfProcess(numVertices, numProcesses, owner);
+            fetchFromWindow(nextWindow, next->data, owner, myRank,
+                            (MPI_Aint) (u - ownerLow) * numVertices + to, elementBytes, entry);
+
+            uint32_t hop = readSuccessor(entry, 0, elementBytes);
+            if (hop == getNoSuccessor(elementBytes)) {
+                break;
+            }
+            u = (int) hop;
+            path.push_back(u);
+        }
+
+        if (u != to) {
+            path.clear();
+        } else {
+            int owner = getProcessOfElement(from, numVertices, numProcesses);
+            int ownerLow = getFirstGraphRowOfProcess(numVertices, numProcesses, owner);
+            fetchFromWindow(distWindow, graph->storage, owner, myRank,
+                            (MPI_Aint) (from - ownerLow) * graph->rowStride + to, sizeof(int),
+                            &distance);
+        }
+    }
+
+    if (numProcesses > 1) {
+        MPI_Win_free(&distWindow);
+        MPI_Win_free(&nextWindow);
+
+        int header[2] = {(int) path.size(), distance};
+        MPI_Bcast(header, 2, MPI_INT, 0, MPI_COMM_WORLD);
+        path.resize(header[0]);
+        MPI_Bcast(path.data(), header[0], MPI_INT, 0, MPI_COMM_WORLD);
+        distance = header[1];
+    }
+
+    if (length != nullptr) {
+        *length = distance;
+    }
+    return path;
+}
+
+void printPaths(Graph* graph, Successors* next, std::vector<int> const& from,
+                std::vector<int> const& to, int numProcesses, int myRank) {
+    assert(from.size() == to.size());
+    int numVertices = graph->numVertices;
+
+    for (size_t q = 0; q < from.size(); ++q) {
+        int u = from[q];
+        int v = to[q];
+
+        if (u < 0 || u >= numVertices || v < 0 || v >= numVertices) {
+            if (myRank == 0) {
+                std::cout << "Invalid vertex pair " << u << " " << v << "." << std::endl;
+            }
+            continue;
+        }
+
+        int distance;
+        std::vector<int> path = getPath(graph, next, u, v, &distance, numProcesses, myRank);
+        if (myRank != 0) {
+            continue;
+        }
+
+        if (path.empty()) {
+            std::cout << "No path from " << u << " to " << v << "." << std::endl;
+            continue;
+        }
+
+        std::cout << "Path from " << u << " to " << v << " (length " << distance << "):";
+        for (int w : path) {
+            std::cout << " " << w;
+        }
+        std::cout << std::endl;
+    }
+}
+
+void destroySuccessors(Successors* next) {
+    if (next == nullptr) {
+        return;
+    }
+
+    delete[] static_cast<uint32_t*>(next->data);
+    delete next;
+}
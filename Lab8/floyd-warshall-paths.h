@@ -0,0 +1,70 @@
+/*
+ * Path reconstruction for Floyd-Warshall: a successor
+ * (next-hop) matrix updated together with the distances.
+ */
+
+#ifndef __MY_FLOYD_WARSHALL_PATHS__H__
+#define __MY_FLOYD_WARSHALL_PATHS__H__
+
+#include <vector>
+#include "graph-base.h"
+
+/**
+ * The successor matrix of the rows of a graph fragment:
+ * the entry (i, j) is the vertex following i on the
+ * shortest path found so far from i to j, or the largest
+ * value of its type if j is unreachable. Entries take
+ * elementBytes = 1, 2 or 4 bytes, the narrowest size that
+ * fits numVertices and the sentinel; the rows are stored
+ * contiguously, numVertices entries apart.
+ */
+class Successors {
+public:
+  void *data;
+  int elementBytes;
+  int numVertices;
+  int firstRowIdxIncl;
+  int lastRowIdxExcl;
+};
+
+/**
+ * Creates the successor matrix for the rows of a graph
+ * before the algorithm runs: (i, j) is j if there is an
+ * edge from i to j, that is, a weight below noEdgeWeight.
+ */
+Successors *createSuccessors(Graph *graph, int noEdgeWeight);
+
+/**
+ * The relaxation of a single local row of a graph through
+ * pivot k that also records the successors of improved
+ * entries. pivotRow holds the distances from k. The loop
+ * stays vectorized for every successor size.
+ */
+void relaxRowWithSuccessors(Graph *graph, Successors *next, int localRow,
+                            int k, int const *pivotRow);
+
+/**
+ * Collectively finds the shortest path from -> to on a
+ * distributed graph: rank 0 follows the successors, fetching
+ * single entries of remote rows with MPI_Get, and broadcasts
+ * the vertices, from and to included. Costs O(path length)
+ * gets. Every process gets the path, and its length in
+ * *length unless length is null; the path is empty if to is
+ * unreachable or either vertex is not in the graph.
+ */
+std::vector<int> getPath(Graph *graph, Successors *next, int from, int to,
+                         int *length, int numProcesses, int myRank);
+
+/**
+ * Collectively answers path queries (from[q], to[q]) with
+ * getPath; rank 0 prints each path with its length.
+ */
+void printPaths(Graph *graph, Successors *next, std::vector<int> const &from,
+                std::vector<int> const &to, int numProcesses, int myRank);
+
+/**
+ * Frees a successor matrix.
+ */
+void destroySuccessors(Successors *next);
+
+#endif /* __MY_FLOYD_WARSHALL_PATHS__H__ */
@@ -4,12 +4,18 @@
  * Refactoring 2019, Łukasz Rączkowski
  */
 
+#include "floyd-warshall-blocked.h"
+#include "floyd-warshall-narrow.h"
+#include "floyd-warshall-paths.h"
+#include "floyd-warshall-squaring.h"
 #include "graph-base.h"
+#include "graph-io.h"
 #include "graph-utils.h"
 #include <cassert>
 #include <iostream>
 #include <mpi.h>
 #include <string>
+#include <vector>
 
 static void runFloydWarshallSequential(Graph *graph) {
   /* For the sequential version, we assume the entire graph. */
@@ -19,9 +25,12 @@ static void runFloydWarshallSequential(Graph *graph) {
 
   for (int k = 0; k < m; ++k) {
     for (int i = 0; i < m; ++i) {
+      if (graph->data[i][k] >= GRAPH_INFINITY) {
+        continue;
+      }
       for (int j = 0; j < m; ++j) {
         int pathSum = graph->data[i][k] + graph->data[k][j];
-        if (graph->data[i][j] > pathSum) {
+        if (graph->data[i][j] > pathSum && graph->data[k][j] < GRAPH_INFINITY) {
           graph->data[i][j] = pathSum;
         }
       }
@@ -29,51 +38,124 @@ static void runFloydWarshallSequential(Graph *graph) {
   }
 }
 
+static void runFloydWarshallSequentialWithPaths(Graph *graph,
+                                                Successors *next) {
+  int m = graph->numVertices;
+
+  for (int k = 0; k < m; ++k) {
+    for (int i = 0; i < m; ++i) {
+      relaxRowWithSuccessors(graph, next, i, k, graph->data[k]);
+    }
+  }
+}
+
 int main(int argc, char *argv[]) {
   int numVertices = 0;
   int showResults = 0;
+  int blocked = 0;
+  int narrow = 0;
+  int squaring = 0;
+  char const *inputPath = nullptr;
+  char const *edgeListPath = nullptr;
+  char const *outputPath = nullptr;
+  std::vector<int> pathFrom;
+  std::vector<int> pathTo;
 
   MPI_Init(&argc, &argv);
 
-#ifdef USE_RANDOM_GRAPH
-#ifdef USE_RANDOM_SEED
-  srand(USE_RANDOM_SEED);
-#endif
-#endif
-
   for (int i = 1; i < argc; ++i) {
     if (std::string(argv[i]).compare("--show-results") == 0) {
       showResults = 1;
+    } else if (std::string(argv[i]).compare("--blocked") == 0) {
+      blocked = 1;
+    } else if (std::string(argv[i]).compare("--narrow") == 0) {
+      narrow = 1;
+    } else if (std::string(argv[i]).compare("--squaring") == 0) {
+      squaring = 1;
+    } else if (std::string(argv[i]).compare("--path") == 0 && i + 2 < argc) {
+      pathFrom.push_back(std::stoi(argv[++i]));
+      pathTo.push_back(std::stoi(argv[++i]));
+    } else if (std::string(argv[i]).compare("--input") == 0 && i + 1 < argc) {
+      inputPath = argv[++i];
+    } else if (std::string(argv[i]).compare("--edge-list") == 0 &&
+               i + 1 < argc) {
+      edgeListPath = argv[++i];
+    } else if (std::string(argv[i]).compare("--output") == 0 && i + 1 < argc) {
+      outputPath = argv[++i];
     } else {
       numVertices = std::stoi(argv[i]);
     }
   }
 
-  if (numVertices <= 0) {
-    std::cerr << "Usage: " << argv[0] << "  [--show-results] <num_vertices>"
+  if ((numVertices <= 0 && inputPath == nullptr && edgeListPath == nullptr) ||
+      (!pathFrom.empty() && (blocked || narrow || squaring))) {
+    std::cerr << "Usage: " << argv[0]
+              << "  [--show-results] [--blocked | --narrow | --squaring]"
+              << " [--output <file>]"
+              << " [--path <from> <to>]..."
+              << " (<num_vertices> | --input <file> | --edge-list <file>)"
               << std::endl;
     MPI_Finalize();
     return 1;
   }
 
-  std::cerr << "Running the Floyd-Warshall algorithm for a graph with "
-            << numVertices << " vertices." << std::endl;
+  Graph *graph = nullptr;
+
+  if (inputPath != nullptr) {
+    graph = readGraphFile(inputPath, 1 /* numProcesses */, 0 /* myRank */);
+  } else if (edgeListPath != nullptr) {
+    graph = readEdgeListFile(edgeListPath, 1 /* numProcesses */,
+                             0 /* myRank */);
+  } else {
+    graph = createAndDistributeGraph(numVertices, 1 /* numProcesses */,
+                                     0 /* myRank */);
+  }
 
-  auto graph = createAndDistributeGraph(numVertices, 1 /* numProcesses */,
-                                        0 /* myRank */);
   if (graph == nullptr) {
     std::cerr << "Error distributing the graph for the algorithm." << std::endl;
     MPI_Finalize();
     return 2;
   }
+  numVertices = graph->numVertices;
+
+  std::cerr << "Running the Floyd-Warshall algorithm for a graph with "
+            << numVertices << " vertices." << std::endl;
 
   if (showResults) {
     collectAndPrintGraph(graph, 1 /* numProcesses */, 0 /* myRank */);
   }
 
+  int noEdgeWeight = inputPath != nullptr || edgeListPath != nullptr
+                         ? GRAPH_IO_INFINITY
+                         : getGraphNoEdgeWeight(numVertices);
+
+  Successors *successors = nullptr;
+  if (!pathFrom.empty()) {
+    successors = createSuccessors(graph, noEdgeWeight);
+  }
+
   double startTime = MPI_Wtime();
 
-  runFloydWarshallSequential(graph);
+  if (successors != nullptr) {
+    runFloydWarshallSequentialWithPaths(graph, successors);
+  } else if (blocked) {
+    runFloydWarshallBlocked(graph->data, graph->numVertices);
+  } else if (narrow) {
+    int bytes = runFloydWarshallNarrow(graph, noEdgeWeight, 1 /* numProcesses */,
+                                       0 /* myRank */);
+    if (bytes == 0) {
+      runFloydWarshallSequential(graph);
+    }
+    std::cerr << "Distances were stored in "
+              << (bytes == 0 ? (int)sizeof(int) : bytes) << " byte(s)."
+              << std::endl;
+  } else if (squaring) {
+    int squarings = runMinPlusSquaring(graph, 1 /* numProcesses */);
+    std::cerr << "Distances converged after " << squarings << " squaring(s)."
+              << std::endl;
+  } else {
+    runFloydWarshallSequential(graph);
+  }
 
   double endTime = MPI_Wtime();
 
@@ -85,6 +167,19 @@ int main(int argc, char *argv[]) {
     collectAndPrintGraph(graph, 1 /* numProcesses */, 0 /* myRank */);
   }
 
+  if (successors != nullptr) {
+    printPaths(graph, successors, pathFrom, pathTo, 1 /* numProcesses */,
+               0 /* myRank */);
+    destroySuccessors(successors);
+  }
+
+  if (outputPath != nullptr &&
+      writeGraphFile(graph, outputPath, 1 /* numProcesses */, 0 /* myRank */) !=
+          0) {
+    std::cerr << "Error writing the graph to " << outputPath << "."
+              << std::endl;
+  }
+
   destroyGraph(graph, 1 /* numProcesses */, 0 /* myRank */);
 
   MPI_Finalize();
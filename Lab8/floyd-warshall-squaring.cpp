@@ -0,0 +1,70 @@
+/*
+ * All-pairs shortest paths by repeated min-plus squaring
+ * of the distance matrix.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <mpi.h>
+#include <vector>
+#include "floyd-warshall-squaring.h"
+#include "graph-base.h"
+#include "graph-io.h"
+#include "min-plus-gemm.h"
+
+int runMinPlusSquaring(Graph* graph, int numProcesses) {
+    assert(numProcesses <= graph->numVertices);
+    int m = graph->numVertices;
+    int low = graph->firstRowIdxIncl;
+    int high = graph->lastRowIdxExcl;
+    int stride = graph->rowStride;
+    std::vector<int> counts(numProcesses);
+    std::vector<int> displs(numProcesses);
+
+    /* Counted in rows, so that they fit in an int for any graph. */
+    for (int p = 0; p < numProcesses; ++p) {
+        int first = getFirstGraphRowOfProcess(m, numProcesses, p);
+        int last = getFirstGraphRowOfProcess(m, numProcesses, p + 1);
+        counts[p] = last - first;
+        displs[p] = first;
+    }
+
+    /*
+     * The matrix before the squaring: both factors, and never written to.
+     * Its rows are padded as in the graph, so one row type gathers them.
+     */
+    std::vector<int> whole((size_t) m * stride);
+    std::vector<int const*> wholeRows(m);
+    for (int i = 0; i < m; ++i) {
+        wholeRows[i] = whole.data() + (size_t) i * stride;
+    }
+    MPI_Datatype rowType = createGraphRowType(graph);
+
+    int squarings = 0;
+
+    /* After s squarings, all paths of up to 2^s edges are accounted for. */
+    for (long long span = 1; span < m - 1; span *= 2) {
+        MPI_Allgatherv(graph->storage, high - low, rowType, whole.data(), counts.data(),
+                       displs.data(), rowType, MPI_COMM_WORLD);
+
+#pragma omp parallel for schedule(dynamic)
+        for (int ib = 0; ib < high - low; ib += SQUARING_ROW_BAND) {
+            int rows = std::min(SQUARING_ROW_BAND, high - low - ib);
+            minPlusGemm(graph->data + ib, 0, wholeRows.data() + low + ib, 0, wholeRows.data(), 0,
+                        rows, m, m);
+        }
+        ++squarings;
+
+        int changed = 0;
+        for (int i = 0; i < high - low && !changed; ++i) {
+            changed = !std::equal(graph->data[i], graph->data[i] + m, wholeRows[low + i]);
+        }
+        MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+        if (!changed) {
+            break;
+        }
+    }
+
+    MPI_Type_free(&rowType);
+    return squarings;
+}
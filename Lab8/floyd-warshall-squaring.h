@@ -0,0 +1,31 @@
+/*
+ * All-pairs shortest paths by repeated min-plus squaring
+ * of the distance matrix.
+ */
+
+#ifndef __MY_FLOYD_WARSHALL_SQUARING__H__
+#define __MY_FLOYD_WARSHALL_SQUARING__H__
+
+#include "graph-base.h"
+#include "min-plus-gemm.h"
+
+/**
+ * Rows of the local fragment handed to one OpenMP
+ * thread at a time by the squaring.
+ */
+#define SQUARING_ROW_BAND (GEMM_MR * 16)
+
+/**
+ * Computes all-pairs shortest paths on a distributed graph
+ * as D = min(D, D (x) D), repeated until paths of up to
+ * numVertices - 1 edges are covered (ceil(log2(numVertices - 1))
+ * squarings) or a squaring changes nothing. Each squaring
+ * gathers the whole matrix at every process, which then
+ * multiplies its rows by it with minPlusGemm: O(n^3 log n / p)
+ * work, but no per-pivot broadcasts. There must be no negative
+ * cycles. Returns the number of squarings performed. Must be
+ * called by all processes.
+ */
+int runMinPlusSquaring(Graph *graph, int numProcesses);
+
+#endif /* __MY_FLOYD_WARSHALL_SQUARING__H__ */
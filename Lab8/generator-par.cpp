@@ -20,12 +20,6 @@ int main(int argc, char *argv[]) {
     MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
     MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
 
-#ifdef USE_RANDOM_GRAPH
-#ifdef USE_RANDOM_SEED
-    srand(USE_RANDOM_SEED);
-#endif
-#endif
-
     if (argc == 2) {
         numVertices = std::stoi(argv[1]);
     }
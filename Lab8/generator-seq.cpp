@@ -16,12 +16,6 @@ int main(int argc, char *argv[]) {
 
     MPI_Init(&argc, &argv);
 
-#ifdef USE_RANDOM_GRAPH
-#ifdef USE_RANDOM_SEED
-    srand(USE_RANDOM_SEED);
-#endif
-#endif
-
     if (argc == 2) {
         numVertices = std::stoi(argv[1]);
     }
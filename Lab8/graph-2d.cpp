@@ -0,0 +1,169 @@
+/*
+ * A 2D block-cyclic distribution of the graph matrix
+ * over a P x Q grid of processes.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <mpi.h>
+#include "graph-base.h"
+#include "graph-2d.h"
+
+#define COLLECT_MSG_TAG 12
+
+ProcessGrid* createProcessGrid(MPI_Comm comm) {
+    int numProcesses;
+    int dims[2] = {0, 0};
+    int periods[2] = {0, 0};
+    int coords[2];
+    int keepCols[2] = {0, 1};
+    int keepRows[2] = {1, 0};
+
+    MPI_Comm_size(comm, &numProcesses);
+    MPI_Dims_create(numProcesses, 2, dims);
+
+    auto grid = new ProcessGrid;
+    grid->numProcRows = dims[0];
+    grid->numProcCols = dims[1];
+    MPI_Cart_create(comm, 2, dims, periods, 0, &grid->gridComm);
+    MPI_Comm_rank(grid->gridComm, &grid->myRank);
+    MPI_Cart_coords(grid->gridComm, grid->myRank, 2, coords);
+    grid->myProcRow = coords[0];
+    grid->myProcCol = coords[1];
+
+    /* rowComm: same process row, ranked by process column; colComm: the converse. */
+    MPI_Cart_sub(grid->gridComm, keepCols, &grid->rowComm);
+    MPI_Cart_sub(grid->gridComm, keepRows, &grid->colComm);
+
+    return grid;
+}
+
+void freeProcessGrid(ProcessGrid* grid) {
+    if (grid == nullptr) {
+        return;
+    }
+
+    MPI_Comm_free(&grid->rowComm);
+    MPI_Comm_free(&grid->colComm);
+    MPI_Comm_free(&grid->gridComm);
+    delete grid;
+}
+
+int getNumLocalIndices(int n, int blockSize, int procIdx, int numProcs) {
+    int numFullBlocks = n / blockSize;
+    int numLocal = (numFullBlocks / numProcs) * blockSize;
+    int numExtraBlocks = numFullBlocks % numProcs;
+
+    if (procIdx < numExtraBlocks) {
+        numLocal += blockSize;
+    } else if (procIdx == numExtraBlocks) {
+        numLocal += n % blockSize;
+    }
+
+    return numLocal;
+}
+
+int getOwnerOfIndex(int globalIdx, int blockSize, int numProcs) {
+    return (globalIdx / blockSize) % numProcs;
+}
+
+int getLocalIndex(int globalIdx, int blockSize, int numProcs) {
+    return (globalIdx / (blockSize * numProcs)) * blockSize + globalIdx % blockSize;
+}
+
+int getGlobalIndex(int localIdx, int blockSize, int procIdx, int numProcs) {
+    return ((localIdx / blockSize) * numProcs + procIdx) * blockSize + localIdx % blockSize;
+}
+
+static int getGridRank(ProcessGrid* grid, int procRow, int procCol) {
+    int coords[2] = {procRow, procCol};
+    int rank;
+    MPI_Cart_rank(grid->gridComm, coords, &rank);
+    return rank;
+}
+
+static void unpackRowSegment(int const* segment, int* row, int numVertices, int blockSize,
+                             int procCol, int numProcCols) {
+    int numLocalCols = getNumLocalIndices(numVertices, blockSize, procCol, numProcCols);
+
+    for (int lj = 0; lj < numLocalCols; ++lj) {
+        row[getGlobalIndex(lj, blockSize, procCol, numProcCols)] = segment[lj];
+    }
+}
+
+GraphBlock2D* createAndDistributeGraph2D(int numVertices, int blockSize, ProcessGrid* grid) {
+    assert(numVertices > 0 && blockSize > 0);
+
+    auto graph = new GraphBlock2D;
+    graph->numVertices = numVertices;
+    graph->blockSize = blockSize;
+    graph->numLocalRows = getNumLocalIndices(numVertices, blockSize, grid->myProcRow, grid->numProcRows);
+    graph->numLocalCols = getNumLocalIndices(numVertices, blockSize, grid->myProcCol, grid->numProcCols);
+    graph->data = new int[(size_t) graph->numLocalRows * graph->numLocalCols];
+
+    /*
+     * Every process generates its own blocks: each run of blockSize
+     * consecutive local columns is a contiguous segment of a global row.
+     */
+    for (int li = 0; li < graph->numLocalRows; ++li) {
+        int i = getGlobalIndex(li, blockSize, grid->myProcRow, grid->numProcRows);
+        int* row = graph->data + (size_t) li * graph->numLocalCols;
+
+        for (int lj = 0; lj < graph->numLocalCols; lj += blockSize) {
+            int numCols = std::min(blockSize, graph->numLocalCols - lj);
+            initializeGraphRowSegment(row + lj, i,
+                                      getGlobalIndex(lj, blockSize, grid->myProcCol, grid->numProcCols),
+                                      numCols, numVertices);
+        }
+    }
+
+    return graph;
+}
+
+void collectAndPrintGraph2D(GraphBlock2D* graph, ProcessGrid* grid) {
+    int numVertices = graph->numVertices;
+    int blockSize = graph->blockSize;
+
+    if (grid->myRank == 0) {
+        int* row = new int[numVertices];
+        int* segment = new int[numVertices];
+
+        for (int i = 0; i < numVertices; ++i) {
+            int procRow = getOwnerOfIndex(i, blockSize, grid->numProcRows);
+            int li = getLocalIndex(i, blockSize, grid->numProcRows);
+
+            for (int procCol = 0; procCol < grid->numProcCols; ++procCol) {
+                int src = getGridRank(grid, procRow, procCol);
+
+                if (src == 0) {
+                    unpackRowSegment(graph->data + (size_t) li * graph->numLocalCols, row,
+                                     numVertices, blockSize, procCol, grid->numProcCols);
+                } else {
+                    MPI_Recv(segment,
+                             getNumLocalIndices(numVertices, blockSize, procCol, grid->numProcCols),
+                             MPI_INT, src, COLLECT_MSG_TAG, grid->gridComm, MPI_STATUS_IGNORE);
+                    unpackRowSegment(segment, row, numVertices, blockSize, procCol, grid->numProcCols);
+                }
+            }
+
+            printGraphRow(row, i, numVertices);
+        }
+
+        delete[] row;
+        delete[] segment;
+    } else {
+        for (int li = 0; li < graph->numLocalRows; ++li) {
+            MPI_Send(graph->data + (size_t) li * graph->numLocalCols, graph->numLocalCols, MPI_INT,
+                     0, COLLECT_MSG_TAG, grid->gridComm);
+        }
+    }
+}
+
+void destroyGraph2D(GraphBlock2D* graph) {
+    if (graph == nullptr) {
+        return;
+    }
+
+    delete[] graph->data;
+    delete graph;
+}
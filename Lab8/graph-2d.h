@@ -0,0 +1,97 @@
+/*
+ * A 2D block-cyclic distribution of the graph matrix
+ * over a P x Q grid of processes.
+ */
+
+#ifndef __MY_GRAPH_2D__H__
+#define __MY_GRAPH_2D__H__
+
+#include <mpi.h>
+
+/**
+ * A P x Q Cartesian grid of processes together with
+ * communicators spanning a single grid row (processes
+ * with the same row coordinate) and a single grid column.
+ */
+class ProcessGrid {
+public:
+  MPI_Comm gridComm;
+  MPI_Comm rowComm;
+  MPI_Comm colComm;
+  int numProcRows;
+  int numProcCols;
+  int myProcRow;
+  int myProcCol;
+  int myRank;
+};
+
+/**
+ * The part of a graph matrix owned by one process.
+ * Blocks of blockSize x blockSize elements are dealt
+ * cyclically: global row i belongs to process row
+ * (i / blockSize) % numProcRows, and likewise for columns.
+ * Local rows and columns are stored contiguously, row-major.
+ */
+class GraphBlock2D {
+public:
+  int *data;
+  int numVertices;
+  int blockSize;
+  int numLocalRows;
+  int numLocalCols;
+};
+
+/**
+ * Creates a process grid as close to square as possible
+ * out of all processes in comm.
+ */
+ProcessGrid *createProcessGrid(MPI_Comm comm);
+
+/**
+ * Frees the communicators of a process grid.
+ */
+void freeProcessGrid(ProcessGrid *grid);
+
+/**
+ * Returns the number of rows (or columns) of an
+ * n-element dimension owned by process coordinate
+ * procIdx out of numProcs.
+ */
+int getNumLocalIndices(int n, int blockSize, int procIdx, int numProcs);
+
+/**
+ * Maps a global index to the process coordinate owning it.
+ */
+int getOwnerOfIndex(int globalIdx, int blockSize, int numProcs);
+
+/**
+ * Maps a global index to the local index on its owner.
+ */
+int getLocalIndex(int globalIdx, int blockSize, int numProcs);
+
+/**
+ * Maps a local index on process coordinate procIdx
+ * back to the global index.
+ */
+int getGlobalIndex(int localIdx, int blockSize, int procIdx, int numProcs);
+
+/**
+ * Creates a graph with a given number of vertices
+ * whose blocks are generated directly by the
+ * processes of the grid that own them.
+ */
+GraphBlock2D *createAndDistributeGraph2D(int numVertices, int blockSize,
+                                         ProcessGrid *grid);
+
+/**
+ * Collects the blocks of a graph at the process with
+ * rank 0 in the grid and prints the entire graph.
+ */
+void collectAndPrintGraph2D(GraphBlock2D *graph, ProcessGrid *grid);
+
+/**
+ * Frees the local part of a graph.
+ */
+void destroyGraph2D(GraphBlock2D *graph);
+
+#endif /* __MY_GRAPH_2D__H__ */
@@ -4,7 +4,9 @@
  * Refactoring 2019, Łukasz Rączkowski
  */
 
+#include <climits>
 #include <iostream>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "graph-base.h"
@@ -14,53 +16,105 @@ Graph* allocateGraphPart(int numVertices, int firstRowIdxIncl, int lastRowIdxExc
         return nullptr;
     }
 
+    int intsPerLine = GRAPH_ROW_ALIGNMENT / sizeof(int);
     auto graph = new Graph;
     graph->data = nullptr;
+    graph->storage = nullptr;
     graph->extraRow = nullptr;
     graph->numVertices = numVertices;
+    graph->rowStride = (numVertices + intsPerLine - 1) / intsPerLine * intsPerLine;
     graph->firstRowIdxIncl = firstRowIdxIncl;
     graph->lastRowIdxExcl = lastRowIdxExcl;
-    graph->data = new int *[graph->lastRowIdxExcl - graph->firstRowIdxIncl];
 
-    if (graph->data == nullptr) {
-        freeGraphPart(graph);
-        return nullptr;
-    }
-
-    graph->extraRow = new int[graph->numVertices];
+    int n = graph->lastRowIdxExcl - graph->firstRowIdxIncl;
+    void* storage = nullptr;
 
-    if (graph->extraRow == nullptr) {
+    if (posix_memalign(&storage, GRAPH_ROW_ALIGNMENT,
+                       (size_t) n * graph->rowStride * sizeof(int)) != 0) {
         freeGraphPart(graph);
         return nullptr;
     }
 
-    int n = graph->lastRowIdxExcl - graph->firstRowIdxIncl;
+    graph->storage = static_cast<int*>(storage);
+    graph->data = new int *[n];
+    graph->extraRow = new int[graph->numVertices];
 
     for (int i = 0; i < n; ++i) {
-        graph->data[i] = nullptr;
+        graph->data[i] = graph->storage + (size_t) i * graph->rowStride;
+        /* The padding is never read as a distance, but keep it defined. */
+        memset(graph->data[i] + numVertices, 0,
+               (graph->rowStride - numVertices) * sizeof(int));
     }
 
-    for (int i = 0; i < n; ++i) {
-        graph->data[i] = new int[graph->numVertices];
+    return graph;
+}
 
-        if (graph->data[i] == nullptr) {
-            freeGraphPart(graph);
-            return nullptr;
-        }
-    }
+#ifdef USE_RANDOM_GRAPH
+#ifdef USE_RANDOM_SEED
+#define GRAPH_RANDOM_SEED ((uint64_t) (USE_RANDOM_SEED))
+#else
+#define GRAPH_RANDOM_SEED ((uint64_t) 0)
+#endif
 
-    return graph;
+/*
+ * Philox4x32-10 (Salmon et al., SC'11): a counter-based generator,
+ * i.e. a keyed bijection of a 128-bit counter. Any element of the
+ * random matrix can be produced independently of all others, so
+ * every process generates exactly its own part.
+ */
+static void philox4x32(uint32_t counter[4], uint64_t seed) {
+    uint32_t key0 = (uint32_t) seed;
+    uint32_t key1 = (uint32_t) (seed >> 32);
+
+    for (int round = 0; round < 10; ++round) {
+        uint64_t product0 = (uint64_t) 0xD2511F53u * counter[0];
+        uint64_t product1 = (uint64_t) 0xCD9E8D57u * counter[2];
+        uint32_t next[4] = {
+            (uint32_t) (product1 >> 32) ^ counter[1] ^ key0,
+            (uint32_t) product1,
+            (uint32_t) (product0 >> 32) ^ counter[3] ^ key1,
+            (uint32_t) product0,
+        };
+
+        memcpy(counter, next, sizeof(next));
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
 }
+#endif
 
-void initializeGraphRow(int* row, int rowIdx, int numVertices) {
-    for (int j = 0; j < numVertices; ++j) {
-        row[j] = rowIdx == j ? 0 :
+int getGraphNoEdgeWeight(int numVertices) {
 #ifndef USE_RANDOM_GRAPH
-        ((rowIdx - j == 1 || j - rowIdx == 1) ? 1 : numVertices + 5);
+    return numVertices + 5;
 #else
-        (rand() & 8191) + 1;
+    return INT_MAX;
 #endif
+}
+
+void initializeGraphRowSegment(int* segment, int rowIdx, int firstColIdx, int numCols,
+                               int numVertices) {
+#ifndef USE_RANDOM_GRAPH
+    for (int c = 0; c < numCols; ++c) {
+        int j = firstColIdx + c;
+        segment[c] = rowIdx == j ? 0 :
+            ((rowIdx - j == 1 || j - rowIdx == 1) ? 1 : getGraphNoEdgeWeight(numVertices));
+    }
+#else
+    /* One Philox block, keyed by (row, col / 4), yields four consecutive columns. */
+    for (int c = 0; c < numCols;) {
+        int j = firstColIdx + c;
+        uint32_t counter[4] = {(uint32_t) (j / 4), (uint32_t) rowIdx, 0, 0};
+        philox4x32(counter, GRAPH_RANDOM_SEED);
+
+        for (int lane = j % 4; lane < 4 && c < numCols; ++lane, ++c, ++j) {
+            segment[c] = rowIdx == j ? 0 : (int) (counter[lane] & 8191) + 1;
+        }
     }
+#endif
+}
+
+void initializeGraphRow(int* row, int rowIdx, int numVertices) {
+    initializeGraphRowSegment(row, rowIdx, 0, numVertices, numVertices);
 }
 
 void printGraphRow(int const* row, int rowIdx, int numVertices) {
@@ -73,28 +127,40 @@ void printGraphRow(int const* row, int rowIdx, int numVertices) {
     std::cout << std::endl;
 }
 
-void freeGraphPart(Graph* graph) {
-    if (graph == nullptr) {
-        return;
+int getFirstGraphRowOfProcess(int numVertices, int numProcesses, int myRank) {
+    int base = numVertices / numProcesses;
+    int extra = numVertices % numProcesses;
+    if (myRank < extra) {
+        return myRank * (base + 1);
+    } else {
+        return extra * (base + 1) + (myRank - extra) * base;
     }
+}
 
-    if (graph->extraRow != nullptr) {
-        delete (graph->extraRow);
-        graph->extraRow = nullptr;
-    }
+int getProcessOfElement(int k, int numVertices, int numProcesses) {
+    int base = numVertices / numProcesses;
+    int extra = numVertices % numProcesses;
+    int threshold = (base + 1) * extra;
 
-    if (graph->data != nullptr) {
-        for (int i = 0, n = graph->lastRowIdxExcl - graph->firstRowIdxIncl; i < n; ++i) {
-            if (graph->data[i] != nullptr) {
-                delete (graph->data[i]);
-                graph->data[i] = nullptr;
-            }
-        }
+    if (k < threshold) {
+        return k / (base + 1);
+    } else {
+        return extra + (k - threshold) / base;
+    }
+}
 
-        delete (graph->data);
-        graph->data = nullptr;
+void freeGraphPart(Graph* graph) {
+    if (graph == nullptr) {
+        return;
     }
 
+    delete[] graph->extraRow;
+    graph->extraRow = nullptr;
+    delete[] graph->data;
+    graph->data = nullptr;
+    free(graph->storage);
+    graph->storage = nullptr;
+
     graph->numVertices = 0;
     graph->firstRowIdxIncl = 0;
     graph->lastRowIdxExcl = 0;
@@ -7,14 +7,35 @@
 #ifndef __MY_GRAPH_BASE__H__
 #define __MY_GRAPH_BASE__H__
 
+#include <climits>
+
+/**
+ * Alignment (in bytes) of the storage of a graph
+ * fragment and of each of its rows.
+ */
+#define GRAPH_ROW_ALIGNMENT 64
+
+/**
+ * Distances at or above this are infinite. The
+ * Floyd-Warshall kernels never relax through them,
+ * so they stay infinite next to negative weights,
+ * as in Johnson's algorithm. Twice this value still
+ * fits in an int, so the relaxation cannot overflow.
+ */
+#define GRAPH_INFINITY (INT_MAX / 2)
+
 /**
  * A fragment of a graph represented as a matrix.
+ * All rows live in a single aligned block, rowStride
+ * ints apart; data[i] points to the i-th local row.
  */
 class Graph {
 public:
   int **data;
+  int *storage;
   int *extraRow;
   int numVertices;
+  int rowStride;
   int firstRowIdxIncl;
   int lastRowIdxExcl;
 };
@@ -24,7 +45,10 @@ public:
  * The matrix, as a whole, has numVertices
  * rows and colums. The fragment comprises
  * entire rows from firstRowIdxIncl (inclusive)
- * to lastRowIdxExcl (exclusive).
+ * to lastRowIdxExcl (exclusive). Each row is
+ * padded to a multiple of GRAPH_ROW_ALIGNMENT
+ * bytes, so consecutive rows form one slab that
+ * can be moved with a single message.
  */
 Graph *allocateGraphPart(int numVertices, int firstRowIdxIncl,
                          int lastRowIdxExcl);
@@ -32,15 +56,44 @@ Graph *allocateGraphPart(int numVertices, int firstRowIdxIncl,
 /**
  * Initializes a single row of a graph either with
  * random or deterministically selected elements.
+ * Random elements depend only on the seed and their
+ * position, so rows can be generated in any order
+ * and on any process.
  */
 void initializeGraphRow(int *row, int rowIdx, int numVertices);
 
+/**
+ * Initializes numCols consecutive elements of
+ * a row, starting from column firstColIdx, with
+ * the same values initializeGraphRow would give.
+ */
+void initializeGraphRowSegment(int *segment, int rowIdx, int firstColIdx,
+                               int numCols, int numVertices);
+
+/**
+ * Returns the weight initializeGraphRow gives to
+ * pairs of vertices that are not joined by an edge
+ * (INT_MAX for random graphs, which are complete).
+ */
+int getGraphNoEdgeWeight(int numVertices);
+
 /**
  * Prints a single row of a graph matrix
  * to the standard output.
  */
 void printGraphRow(int const *row, int rowIdx, int numVertices);
 
+/**
+ * returns the first row (global index) of a process having a given rank
+ */
+int getFirstGraphRowOfProcess(int numVertices, int numProcesses, int myRank);
+
+/**
+ * Returns the rank of the process owning row k
+ * (the inverse of getFirstGraphRowOfProcess).
+ */
+int getProcessOfElement(int k, int numVertices, int numProcesses);
+
 /**
  * Frees a fragment of a graph matrix.
  */
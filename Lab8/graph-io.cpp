@@ -0,0 +1,275 @@
+/*
+ * Binary and edge-list graph files read and written
+ * collectively by all processes with MPI-IO.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "graph-base.h"
+#include "graph-io.h"
+
+#define EDGE_LIST_MIN_CHUNK (1 << 16)
+#define EDGE_LIST_MSG_TAG 21
+
+MPI_Datatype createGraphRowType(Graph* graph) {
+    MPI_Datatype row;
+    MPI_Datatype paddedRow;
+
+    MPI_Type_contiguous(graph->numVertices, MPI_INT, &row);
+    MPI_Type_create_resized(row, 0, (MPI_Aint) graph->rowStride * sizeof(int), &paddedRow);
+    MPI_Type_commit(&paddedRow);
+    MPI_Type_free(&row);
+
+    return paddedRow;
+}
+
+/* Makes a local success flag (non-zero) global, so that all processes fail together. */
+static int allSucceeded(int ok) {
+    int allOk;
+    MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    return allOk;
+}
+
+static MPI_Offset getRowOffset(int rowIdx, int numVertices) {
+    return (GRAPH_FILE_HEADER_INTS + (MPI_Offset) rowIdx * numVertices) * (MPI_Offset) sizeof(int);
+}
+
+Graph* readGraphFile(char const* path, int numProcesses, int myRank) {
+    assert(numProcesses >= 1 && myRank >= 0 && myRank < numProcesses);
+    MPI_File file;
+    int header[GRAPH_FILE_HEADER_INTS] = {0};
+    MPI_Offset fileSize = 0;
+
+    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        return nullptr;
+    }
+
+    int ok = MPI_File_read_at_all(file, 0, header, GRAPH_FILE_HEADER_INTS, MPI_INT,
+                                  MPI_STATUS_IGNORE) == MPI_SUCCESS;
+    MPI_File_get_size(file, &fileSize);
+
+    int numVertices = header[1];
+    ok = allSucceeded(ok && header[0] == GRAPH_FILE_MAGIC && numVertices >= numProcesses &&
+                      fileSize >= getRowOffset(numVertices, numVertices));
+
+    if (!ok) {
+        MPI_File_close(&file);
+        return nullptr;
+    }
+
+    int low = getFirstGraphRowOfProcess(numVertices, numProcesses, myRank);
+    int high = getFirstGraphRowOfProcess(numVertices, numProcesses, myRank + 1);
+    auto graph = allocateGraphPart(numVertices, low, high);
+    MPI_Datatype rowType = createGraphRowType(graph);
+
+    ok = MPI_File_read_at_all(file, getRowOffset(low, numVertices), graph->storage, high - low,
+                              rowType, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+
+    MPI_Type_free(&rowType);
+    MPI_File_close(&file);
+
+    if (!allSucceeded(ok)) {
+        freeGraphPart(graph);
+        delete graph;
+        return nullptr;
+    }
+
+    return graph;
+}
+
+int writeGraphFile(Graph* graph, char const* path, int numProcesses, int myRank) {
+    assert(numProcesses >= 1 && myRank >= 0 && myRank < numProcesses);
+    int numVertices = graph->numVertices;
+    int header[GRAPH_FILE_HEADER_INTS] = {GRAPH_FILE_MAGIC, numVertices, 0, 0};
+    MPI_File file;
+
+    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                      &file) != MPI_SUCCESS) {
+        return -1;
+    }
+
+    /* Truncates an older, larger file. */
+    MPI_File_set_size(file, getRowOffset(numVertices, numVertices));
+
+    MPI_Datatype rowType = createGraphRowType(graph);
+    int ok = MPI_File_write_at_all(file, 0, header, myRank == 0 ? GRAPH_FILE_HEADER_INTS : 0,
+                                   MPI_INT, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+    ok = MPI_File_write_at_all(file, getRowOffset(graph->firstRowIdxIncl, numVertices),
+                               graph->storage, graph->lastRowIdxExcl - graph->firstRowIdxIncl,
+                               rowType, MPI_STATUS_IGNORE) == MPI_SUCCESS && ok;
+
+    MPI_Type_free(&rowType);
+    MPI_File_close(&file);
+
+    return allSucceeded(ok) ? 0 : -1;
+}
+
+/*
+ * Parses "u v w" lines into edge triples. Returns 0 on a
+ * malformed line. maxVertex is raised to the largest id seen.
+ */
+static int parseEdgeList(char const* text, size_t length, std::vector<int>& edges,
+                         int& maxVertex) {
+    std::string buffer(text, length);
+    char const* line = buffer.c_str();
+    char const* end = line + length;
+
+    while (line < end) {
+        char const* next = strchr(line, '\n');
+        next = next == nullptr ? end : next + 1;
+
+        while (line < next && isspace((unsigned char) *line)) {
+            ++line;
+        }
+
+        if (line < next && *line != '#' && *line != '%') {
+            long values[3];
+            char* parsed = const_cast<char*>(line);
+
+            for (int f = 0; f < 3; ++f) {
+                char* fieldStart = parsed;
+                values[f] = strtol(fieldStart, &parsed, 10);
+
+                if (parsed == fieldStart || parsed > next) {
+                    return 0;
+                }
+            }
+
+            while (parsed < next && isspace((unsigned char) *parsed)) {
+                ++parsed;
+            }
+
+            if (parsed != next || values[0] < 0 || values[1] < 0 || values[0] >= INT_MAX ||
+                values[1] >= INT_MAX || values[2] <= -GRAPH_IO_INFINITY ||
+                values[2] >= GRAPH_IO_INFINITY) {
+                return 0;
+            }
+
+            edges.push_back((int) values[0]);
+            edges.push_back((int) values[1]);
+            edges.push_back((int) values[2]);
+            maxVertex = std::max(maxVertex, (int) std::max(values[0], values[1]));
+        }
+
+        line = next;
+    }
+
+    return 1;
+}
+
+Graph* readEdgeListFile(char const* path, int numProcesses, int myRank) {
+    assert(numProcesses >= 1 && myRank >= 0 && myRank < numProcesses);
+    MPI_File file;
+    MPI_Offset fileSize = 0;
+
+    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        return nullptr;
+    }
+
+    /* Equal byte ranges; tiny files are left to the first few processes. */
+    MPI_File_get_size(file, &fileSize);
+    MPI_Offset chunk = std::max((fileSize + numProcesses - 1) / numProcesses,
+                                (MPI_Offset) EDGE_LIST_MIN_CHUNK);
+    MPI_Offset start = std::min(myRank * chunk, fileSize);
+    MPI_Offset end = std::min(start + chunk, fileSize);
+    std::vector<char> text(end - start);
+
+    /* Counts are ints: reads of at most INT_MAX bytes, as many on every process. */
+    MPI_Offset numReads = (end - start + INT_MAX - 1) / INT_MAX;
+    MPI_Allreduce(MPI_IN_PLACE, &numReads, 1, MPI_OFFSET, MPI_MAX, MPI_COMM_WORLD);
+
+    int ok = 1;
+    for (MPI_Offset r = 0; r < numReads; ++r) {
+        MPI_Offset offset = std::min(r * INT_MAX, end - start);
+        int length = (int) std::min(end - start - offset, (MPI_Offset) INT_MAX);
+        ok = MPI_File_read_at_all(file, start + offset, text.data() + offset, length, MPI_CHAR,
+                                  MPI_STATUS_IGNORE) == MPI_SUCCESS && ok;
+    }
+    MPI_File_close(&file);
+
+    /*
+     * Every range but the first hands everything up to its first newline
+     * over to the previous process, which completes its last line with it.
+     */
+    int headLength = 0;
+    if (myRank > 0) {
+        auto newline = std::find(text.begin(), text.end(), '\n');
+        ok = ok && (newline != text.end() || end == fileSize);
+        headLength = (int) (newline == text.end() ? text.size() : newline - text.begin() + 1);
+    }
+
+    int left = myRank > 0 ? myRank - 1 : MPI_PROC_NULL;
+    int right = myRank + 1 < numProcesses ? myRank + 1 : MPI_PROC_NULL;
+    int tailLength = 0;
+
+    MPI_Sendrecv(&headLength, 1, MPI_INT, left, EDGE_LIST_MSG_TAG, &tailLength, 1, MPI_INT, right,
+                 EDGE_LIST_MSG_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    text.resize(text.size() + tailLength);
+    MPI_Sendrecv(text.data(), headLength, MPI_CHAR, left, EDGE_LIST_MSG_TAG,
+                 text.data() + (end - start), tailLength, MPI_CHAR, right, EDGE_LIST_MSG_TAG,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+    std::vector<int> edges;
+    int maxVertex = -1;
+    ok = ok && parseEdgeList(text.data() + headLength, text.size() - headLength, edges, maxVertex);
+
+    int numVertices;
+    MPI_Allreduce(&maxVertex, &numVertices, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    ++numVertices;
+
+    if (!allSucceeded(ok && numVertices >= numProcesses)) {
+        return nullptr;
+    }
+
+    /* Routes every edge to the owner of its source row. */
+    std::vector<int> sendCounts(numProcesses, 0);
+    std::vector<int> recvCounts(numProcesses);
+    std::vector<int> sendDispls(numProcesses + 1, 0);
+    std::vector<int> recvDispls(numProcesses + 1, 0);
+
+    for (size_t e = 0; e < edges.size(); e += 3) {
+        sendCounts[getProcessOfElement(edges[e], numVertices, numProcesses)] += 3;
+    }
+
+    MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+
+    for (int p = 0; p < numProcesses; ++p) {
+        sendDispls[p + 1] = sendDispls[p] + sendCounts[p];
+        recvDispls[p + 1] = recvDispls[p] + recvCounts[p];
+    }
+
+    std::vector<int> sendEdges(edges.size());
+    std::vector<int> recvEdges(recvDispls[numProcesses]);
+    std::vector<int> fill(sendDispls.begin(), sendDispls.end() - 1);
+
+    for (size_t e = 0; e < edges.size(); e += 3) {
+        int& pos = fill[getProcessOfElement(edges[e], numVertices, numProcesses)];
+        std::copy(&edges[e], &edges[e] + 3, &sendEdges[pos]);
+        pos += 3;
+    }
+
+    MPI_Alltoallv(sendEdges.data(), sendCounts.data(), sendDispls.data(), MPI_INT,
+                  recvEdges.data(), recvCounts.data(), recvDispls.data(), MPI_INT,
+                  MPI_COMM_WORLD);
+
+    int low = getFirstGraphRowOfProcess(numVertices, numProcesses, myRank);
+    int high = getFirstGraphRowOfProcess(numVertices, numProcesses, myRank + 1);
+    auto graph = allocateGraphPart(numVertices, low, high);
+
+    for (int i = low; i < high; ++i) {
+        std::fill(graph->data[i - low], graph->data[i - low] + numVertices, GRAPH_IO_INFINITY);
+        graph->data[i - low][i] = 0;
+    }
+
+    for (size_t e = 0; e < recvEdges.size(); e += 3) {
+        int& distance = graph->data[recvEdges[e] - low][recvEdges[e + 1]];
+        distance = std::min(distance, recvEdges[e + 2]);
+    }
+
+    return graph;
+}
@@ -0,0 +1,69 @@
+/*
+ * Binary and edge-list graph files read and written
+ * collectively by all processes with MPI-IO.
+ */
+
+#ifndef __MY_GRAPH_IO__H__
+#define __MY_GRAPH_IO__H__
+
+#include <climits>
+#include <mpi.h>
+#include "graph-base.h"
+
+/**
+ * The first word of a binary graph file ("FWG1").
+ */
+#define GRAPH_FILE_MAGIC 0x31475746
+
+/**
+ * A binary graph file starts with GRAPH_FILE_HEADER_INTS
+ * native-endian int32 words: GRAPH_FILE_MAGIC, the number
+ * of vertices and two reserved zeros. The numVertices x
+ * numVertices matrix follows, row by row, as int32.
+ */
+#define GRAPH_FILE_HEADER_INTS 4
+
+/**
+ * The distance given to pairs of vertices without an
+ * edge when importing an edge list.
+ */
+#define GRAPH_IO_INFINITY GRAPH_INFINITY
+
+/**
+ * Creates a committed datatype describing one row of
+ * a graph fragment in memory: numVertices ints whose
+ * extent includes the padding up to rowStride.
+ */
+MPI_Datatype createGraphRowType(Graph *graph);
+
+/**
+ * Reads a binary graph file. Every process reads its
+ * own block of rows (as in createAndDistributeGraph)
+ * with a single collective call. Returns nullptr at all
+ * processes if the file cannot be read or has fewer
+ * vertices than there are processes.
+ */
+Graph *readGraphFile(char const *path, int numProcesses, int myRank);
+
+/**
+ * Imports a text edge list with one "u v w" line
+ * (0-based vertices, int weight) per directed edge.
+ * Empty lines and lines starting with '#' or '%'
+ * are skipped. Each process parses an equal byte range
+ * of the file and the edges are routed to the owners of
+ * their rows with MPI_Alltoallv. The number of vertices
+ * is one more than the largest vertex id; missing edges
+ * get GRAPH_IO_INFINITY and parallel edges the smallest
+ * weight. Returns nullptr at all processes on error.
+ */
+Graph *readEdgeListFile(char const *path, int numProcesses, int myRank);
+
+/**
+ * Writes a distributed graph to a binary graph file,
+ * every process writing its own rows collectively.
+ * Returns 0 on success at all processes.
+ */
+int writeGraphFile(Graph *graph, char const *path, int numProcesses,
+                   int myRank);
+
+#endif /* __MY_GRAPH_IO__H__ */
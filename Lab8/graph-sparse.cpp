@@ -0,0 +1,277 @@
+/*
+ * A compressed sparse row (CSR) copy of a graph
+ * and all-pairs shortest paths with Johnson's algorithm.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <mpi.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "graph-base.h"
+#include "graph-sparse.h"
+
+/* Whether entry j of row i is an edge. */
+static inline bool isEdge(int i, int j, int weight, int noEdgeWeight) {
+    return j != i && weight < noEdgeWeight;
+}
+
+/* Broadcasts count ints from root, in pieces that fit the int count of MPI. */
+static void broadcastInPieces(int* data, int64_t count, int root) {
+    for (int64_t done = 0; done < count; done += INT_MAX) {
+        MPI_Bcast(data + done, (int) std::min(count - done, (int64_t) INT_MAX), MPI_INT, root,
+                  MPI_COMM_WORLD);
+    }
+}
+
+SparseGraph* createSparseGraph(Graph* graph, int noEdgeWeight, int numProcesses, int myRank) {
+    assert(numProcesses >= 1 && myRank >= 0 && myRank < numProcesses);
+    int numVertices = graph->numVertices;
+    int low = graph->firstRowIdxIncl;
+    int high = graph->lastRowIdxExcl;
+    std::vector<int64_t> degrees;
+    std::vector<int> columns;
+    std::vector<int> weights;
+    int hasNegativeWeights = 0;
+
+    for (int i = low; i < high; ++i) {
+        int const* row = graph->data[i - low];
+        int64_t degree = 0;
+
+        for (int j = 0; j < numVertices; ++j) {
+            if (isEdge(i, j, row[j], noEdgeWeight)) {
+                columns.push_back(j);
+                weights.push_back(row[j]);
+                hasNegativeWeights |= row[j] < 0;
+                ++degree;
+            }
+        }
+        degrees.push_back(degree);
+    }
+
+    /* Row blocks are ordered by rank, so gathering them in rank order yields the CSR. */
+    std::vector<int> rowCounts(numProcesses);
+    std::vector<int> rowDispls(numProcesses);
+    std::vector<int64_t> edgeCounts(numProcesses);
+    int numLocalRows = high - low;
+    int64_t numLocalEdges = (int64_t) columns.size();
+
+    MPI_Allgather(&numLocalRows, 1, MPI_INT, rowCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    MPI_Allgather(&numLocalEdges, 1, MPI_INT64_T, edgeCounts.data(), 1, MPI_INT64_T,
+                  MPI_COMM_WORLD);
+
+    int64_t numEdges = 0;
+    for (int p = 0, rows = 0; p < numProcesses; ++p) {
+        rowDispls[p] = rows;
+        rows += rowCounts[p];
+        numEdges += edgeCounts[p];
+    }
+
+    auto sparse = new SparseGraph;
+    sparse->numVertices = numVertices;
+    sparse->numEdges = numEdges;
+    sparse->rowOffsets = new int64_t[numVertices + 1];
+    sparse->columns = new int[std::max(numEdges, (int64_t) 1)];
+    sparse->weights = new int[std::max(numEdges, (int64_t) 1)];
+
+    MPI_Allgatherv(degrees.data(), numLocalRows, MPI_INT64_T, sparse->rowOffsets + 1,
+                   rowCounts.data(), rowDispls.data(), MPI_INT64_T, MPI_COMM_WORLD);
+
+    /* Every process broadcasts its edges in turn, straight into their place. */
+    int64_t offset = 0;
+    for (int p = 0; p < numProcesses; ++p) {
+        if (p == myRank) {
+            std::copy(columns.begin(), columns.end(), sparse->columns + offset);
+            std::copy(weights.begin(), weights.end(), sparse->weights + offset);
+        }
+        broadcastInPieces(sparse->columns + offset, edgeCounts[p], p);
+        broadcastInPieces(sparse->weights + offset, edgeCounts[p], p);
+        offset += edgeCounts[p];
+    }
+    MPI_Allreduce(&hasNegativeWeights, &sparse->hasNegativeWeights, 1, MPI_INT, MPI_LOR,
+                  MPI_COMM_WORLD);
+
+    sparse->rowOffsets[0] = 0;
+    for (int u = 0; u < numVertices; ++u) {
+        sparse->rowOffsets[u + 1] += sparse->rowOffsets[u];
+    }
+
+    return sparse;
+}
+
+int64_t countEdges(Graph* graph, int noEdgeWeight) {
+    int64_t numLocalEdges = 0;
+    int64_t numEdges;
+
+    for (int i = graph->firstRowIdxIncl; i < graph->lastRowIdxExcl; ++i) {
+        int const* row = graph->data[i - graph->firstRowIdxIncl];
+        for (int j = 0; j < graph->numVertices; ++j) {
+            numLocalEdges += isEdge(i, j, row[j], noEdgeWeight);
+        }
+    }
+
+    MPI_Allreduce(&numLocalEdges, &numEdges, 1, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+    return numEdges;
+}
+
+int isJohnsonPreferable(int numVertices, int64_t numEdges) {
+    /* FW does V^3 min-plus updates, Johnson about V * E * log2(V) heap work. */
+    double v = numVertices;
+    double johnsonCost = APSP_JOHNSON_COST_FACTOR * v * (double) numEdges * std::log2(v + 1.0);
+
+    return johnsonCost < v * v * v;
+}
+
+/*
+ * A monotone priority queue for integer keys: an element lives in the
+ * bucket given by the highest bit in which its key differs from the
+ * last extracted minimum, so every element moves down at most 64 times.
+ */
+class RadixHeap {
+public:
+    RadixHeap() : last(0), size(0) {}
+
+    bool empty() const {
+        return size == 0;
+    }
+
+    /* Allows keys to start from zero again once the heap is empty. */
+    void reset() {
+        assert(size == 0);
+        last = 0;
+    }
+
+    void push(uint64_t key, int value) {
+        assert(key >= last);
+        buckets[getBucket(key)].emplace_back(key, value);
+        ++size;
+    }
+
+    std::pair<uint64_t, int> pop() {
+        if (buckets[0].empty()) {
+            int b = 1;
+            while (buckets[b].empty()) {
+                ++b;
+            }
+
+            last = std::min_element(buckets[b].begin(), buckets[b].end())->first;
+            for (auto const& entry : buckets[b]) {
+                buckets[getBucket(entry.first)].push_back(entry);
+            }
+            buckets[b].clear();
+        }
+
+        auto top = buckets[0].back();
+        buckets[0].pop_back();
+        --size;
+        return top;
+    }
+
+private:
+    int getBucket(uint64_t key) const {
+        return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+    }
+
+    std::vector<std::pair<uint64_t, int>> buckets[65];
+    uint64_t last;
+    size_t size;
+};
+
+/*
+ * Bellman-Ford from a virtual source joined to every vertex with
+ * zero-weight edges. Returns false if a negative cycle exists.
+ */
+static bool computePotentials(SparseGraph const* sparse, std::vector<int64_t>& potentials) {
+    int numVertices = sparse->numVertices;
+    potentials.assign(numVertices, 0);
+
+    for (int round = 0; round <= numVertices; ++round) {
+        bool changed = false;
+
+        for (int u = 0; u < numVertices; ++u) {
+            for (int64_t e = sparse->rowOffsets[u]; e < sparse->rowOffsets[u + 1]; ++e) {
+                int64_t candidate = potentials[u] + sparse->weights[e];
+                if (candidate < potentials[sparse->columns[e]]) {
+                    potentials[sparse->columns[e]] = candidate;
+                    changed = true;
+                }
+            }
+        }
+
+        if (!changed) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int runJohnson(Graph* graph, SparseGraph const* sparse, int noEdgeWeight) {
+    int numVertices = sparse->numVertices;
+    int low = graph->firstRowIdxIncl;
+    int high = graph->lastRowIdxExcl;
+    std::vector<int64_t> potentials(numVertices, 0);
+
+    assert(graph->numVertices == numVertices);
+
+    if (sparse->hasNegativeWeights && !computePotentials(sparse, potentials)) {
+        return -1;
+    }
+
+#pragma omp parallel
+    {
+        std::vector<uint64_t> distances(numVertices);
+        RadixHeap heap;
+
+#pragma omp for schedule(dynamic)
+        for (int s = low; s < high; ++s) {
+            /* Reduced weights w + h(u) - h(v) are non-negative. */
+            std::fill(distances.begin(), distances.end(), UINT64_MAX);
+            distances[s] = 0;
+            heap.reset();
+            heap.push(0, s);
+
+            while (!heap.empty()) {
+                auto top = heap.pop();
+                int u = top.second;
+                if (top.first != distances[u]) {
+                    continue;
+                }
+
+                for (int64_t e = sparse->rowOffsets[u]; e < sparse->rowOffsets[u + 1]; ++e) {
+                    int v = sparse->columns[e];
+                    uint64_t candidate =
+                        top.first + (uint64_t) (sparse->weights[e] + potentials[u] - potentials[v]);
+                    if (candidate < distances[v]) {
+                        distances[v] = candidate;
+                        heap.push(candidate, v);
+                    }
+                }
+            }
+
+            int* row = graph->data[s - low];
+            for (int v = 0; v < numVertices; ++v) {
+                int64_t distance = distances[v] == UINT64_MAX
+                    ? noEdgeWeight
+                    : (int64_t) distances[v] - potentials[s] + potentials[v];
+                row[v] = (int) std::min(distance, (int64_t) noEdgeWeight);
+            }
+        }
+    }
+
+    return 0;
+}
+
+void destroySparseGraph(SparseGraph* sparse) {
+    if (sparse == nullptr) {
+        return;
+    }
+
+    delete[] sparse->rowOffsets;
+    delete[] sparse->columns;
+    delete[] sparse->weights;
+    delete sparse;
+}
@@ -0,0 +1,72 @@
+/*
+ * A compressed sparse row (CSR) copy of a graph
+ * and all-pairs shortest paths with Johnson's algorithm.
+ */
+
+#ifndef __MY_GRAPH_SPARSE__H__
+#define __MY_GRAPH_SPARSE__H__
+
+#include <stdint.h>
+#include "graph-base.h"
+
+/**
+ * How many times more a heap-based Dijkstra step (per
+ * edge and log2 of the number of vertices) is assumed
+ * to cost than one vectorized min-plus update of FW.
+ */
+#define APSP_JOHNSON_COST_FACTOR 16
+
+/**
+ * The whole graph in the CSR format: the edges leaving
+ * vertex u are columns[rowOffsets[u] .. rowOffsets[u + 1])
+ * with the corresponding weights.
+ */
+class SparseGraph {
+public:
+  int64_t *rowOffsets;
+  int *columns;
+  int *weights;
+  int numVertices;
+  int64_t numEdges;
+  int hasNegativeWeights;
+};
+
+/**
+ * Builds the CSR form of a distributed dense graph at
+ * every process. Entries equal to or greater than
+ * noEdgeWeight, and the diagonal, are not edges.
+ * Every process broadcasts its edges in turn, in
+ * pieces of at most INT_MAX entries.
+ */
+SparseGraph *createSparseGraph(Graph *graph, int noEdgeWeight,
+                               int numProcesses, int myRank);
+
+/**
+ * Counts the edges of a distributed dense graph, as
+ * createSparseGraph would find them, without building
+ * anything. The result is known at every process.
+ */
+int64_t countEdges(Graph *graph, int noEdgeWeight);
+
+/**
+ * Tells whether Johnson's algorithm is expected to be faster
+ * than Floyd-Warshall for a graph of the given size.
+ */
+int isJohnsonPreferable(int numVertices, int64_t numEdges);
+
+/**
+ * Computes the rows of the distance matrix owned by
+ * graph, one Dijkstra run (with a radix heap) per row,
+ * distributed over OpenMP threads. Negative weights are
+ * handled by Johnson's reweighting. Unreachable vertices
+ * get noEdgeWeight. Returns -1 if there is a negative
+ * cycle, leaving graph untouched, or 0 otherwise.
+ */
+int runJohnson(Graph *graph, SparseGraph const *sparse, int noEdgeWeight);
+
+/**
+ * Frees a sparse graph.
+ */
+void destroySparseGraph(SparseGraph *sparse);
+
+#endif /* __MY_GRAPH_SPARSE__H__ */
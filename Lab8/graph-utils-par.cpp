@@ -7,18 +7,10 @@
 #include <cassert>
 #include <mpi.h>
 #include "graph-base.h"
+#include "graph-io.h"
 #include "graph-utils.h"
 #include <algorithm>
 #include <iostream>
-int getFirstGraphRowOfProcess(int numVertices, int numProcesses, int myRank) {
-    int base = numVertices / numProcesses;
-    int extra = numVertices % numProcesses;
-    if (myRank < extra) {
-        return myRank * (base + 1);
-    } else {
-        return extra * (base + 1) + (myRank - extra) * base;
-    }
-}
 
 Graph* createAndDistributeGraph(int numVertices, int numProcesses, int myRank) {
     assert(numProcesses >= 1 && myRank >= 0 && myRank < numProcesses);
@@ -36,36 +28,12 @@ Graph* createAndDistributeGraph(int numVertices, int numProcesses, int myRank) {
 
     assert(graph->numVertices > 0 && graph->numVertices == numVertices);
     assert(graph->firstRowIdxIncl >= 0 && graph->lastRowIdxExcl <= graph->numVertices);
-    if (myRank == 0)
-    {
-        int *buffer;
-        buffer = new int[graph->numVertices];
-        for (int i = 0;i < high-low;i++) initializeGraphRow(graph->data[i], i, graph->numVertices);
-        int RankToSend = 1;
-        
-        while (RankToSend < numProcesses)
-        {
-            int low_rank = getFirstGraphRowOfProcess(numVertices, numProcesses, RankToSend);
-            int high_rank = getFirstGraphRowOfProcess(numVertices, numProcesses, RankToSend + 1);
-            for (int i = low_rank;i < high_rank;i++)
-            {
-                initializeGraphRow(buffer, i, graph->numVertices);
-                MPI_Send(buffer,graph->numVertices,MPI_INT,RankToSend,0,MPI_COMM_WORLD);
-            }
-            RankToSend++;
-        }
-        delete[] buffer;
-    }
-    else
-    {
-        MPI_Status stat;
-        for (int i = 0; i < high-low;i++)
-        {
-            MPI_Recv(graph->data[i],graph->numVertices,MPI_INT,0,0,MPI_COMM_WORLD,&stat);
-        }
-    }
-    for (int i = 0; i < high-low; i++) {
+
+    /* No communication: every process generates exactly its own rows. */
+    for (int i = 0; i < high - low; ++i) {
+        initializeGraphRow(graph->data[i], low + i, graph->numVertices);
     }
+
     return graph;
 }
 
@@ -74,26 +42,36 @@ void collectAndPrintGraph(Graph* graph, int numProcesses, int myRank) {
     assert(graph->numVertices > 0);
     assert(graph->firstRowIdxIncl >= 0 && graph->lastRowIdxExcl <= graph->numVertices);
 
-    int low = getFirstGraphRowOfProcess(graph -> numVertices, numProcesses, myRank);
-    int high = getFirstGraphRowOfProcess(graph -> numVertices, numProcesses, myRank + 1);
-    int dummy = 0;
-    MPI_Status stat;
-    if (myRank == 0)
-    {
-        for (int i = 0; i < high-low; i++) {
-            printGraphRow(graph->data[i], i, graph->numVertices);
+    int numVertices = graph->numVertices;
+    int low = graph->firstRowIdxIncl;
+    int high = graph->lastRowIdxExcl;
+    MPI_Datatype rowType = createGraphRowType(graph);
+
+    if (myRank == 0) {
+        for (int i = 0; i < high - low; ++i) {
+            printGraphRow(graph->data[i], low + i, numVertices);
         }
-        MPI_Send(&dummy,1,MPI_INT,myRank+1,0,MPI_COMM_WORLD);
-        MPI_Recv(&dummy,1,MPI_INT,numProcesses-1,0,MPI_COMM_WORLD,&stat);
-    }
-    else
-    {
-        MPI_Recv(&dummy,1,MPI_INT,myRank-1,0,MPI_COMM_WORLD,&stat);
-        for (int i = 0; i < high-low; i++) {
-            printGraphRow(graph->data[i], i, graph->numVertices);
+
+        auto slab = allocateGraphPart(numVertices, low, high);
+
+        for (int rank = 1; rank < numProcesses; ++rank) {
+            int rankLow = getFirstGraphRowOfProcess(numVertices, numProcesses, rank);
+            int rankHigh = getFirstGraphRowOfProcess(numVertices, numProcesses, rank + 1);
+
+            MPI_Recv(slab->storage, rankHigh - rankLow, rowType, rank, 0, MPI_COMM_WORLD,
+                     MPI_STATUS_IGNORE);
+            for (int i = rankLow; i < rankHigh; ++i) {
+                printGraphRow(slab->data[i - rankLow], i, numVertices);
+            }
         }
-        MPI_Send(&dummy,1,MPI_INT,(myRank+1) % numProcesses,0,MPI_COMM_WORLD);
+
+        freeGraphPart(slab);
+        delete slab;
+    } else {
+        MPI_Send(graph->storage, high - low, rowType, 0, 0, MPI_COMM_WORLD);
     }
+
+    MPI_Type_free(&rowType);
 }
 
 void destroyGraph(Graph* graph, int numProcesses, int myRank) {
@@ -32,9 +32,4 @@ void collectAndPrintGraph(Graph* graph, int numProcesses, int myRank);
  */
 void destroyGraph(Graph* graph, int numProcesses, int myRank);
 
-/**
- * returns the first row (global index) of a process having a given rank
- */
-int getFirstGraphRowOfProcess(int numVertices, int numProcesses, int myRank);
-
 #endif /* __MY_GRAPH_UTILS__H__ */
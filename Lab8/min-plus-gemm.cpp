@@ -0,0 +1,141 @@
+/*
+ * A blocked, register-tiled min-plus (tropical) matrix product.
+ */
+
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "graph-base.h"
+#include "min-plus-gemm.h"
+
+/* Any tile, element by element; used for the edges of C. */
+static void minPlusTileScalar(int* const* cRows, int cCol, int const* const* aRows, int aCol,
+                              int const* const* bRows, int bCol, int rows, int cols, int depth) {
+    for (int i = 0; i < rows; ++i) {
+        int* c = cRows[i] + cCol;
+        int const* a = aRows[i] + aCol;
+
+        for (int k = 0; k < depth; ++k) {
+            int const* b = bRows[k] + bCol;
+            int aik = a[k];
+            if (aik >= GRAPH_INFINITY) {
+                continue;
+            }
+
+            for (int j = 0; j < cols; ++j) {
+                c[j] = b[j] < GRAPH_INFINITY ? std::min(c[j], aik + b[j]) : c[j];
+            }
+        }
+    }
+}
+
+#ifdef __AVX2__
+/*
+ * The micro-kernel for blocks with a negative entry: a sum with a
+ * term at or above GRAPH_INFINITY is replaced by that term, which
+ * cannot be below an element of C.
+ */
+static void minPlusMicroKernelAbsorbing(int* const* cRows, int cCol, int const* const* aRows,
+                                        int aCol, int const* const* bRows, int bCol, int depth) {
+    __m256i c[GEMM_MR][2];
+    __m256i infinity = _mm256_set1_epi32(GRAPH_INFINITY - 1);
+
+    for (int r = 0; r < GEMM_MR; ++r) {
+        c[r][0] = _mm256_loadu_si256((__m256i const*) (cRows[r] + cCol));
+        c[r][1] = _mm256_loadu_si256((__m256i const*) (cRows[r] + cCol + 8));
+    }
+
+    for (int k = 0; k < depth; ++k) {
+        __m256i b0 = _mm256_loadu_si256((__m256i const*) (bRows[k] + bCol));
+        __m256i b1 = _mm256_loadu_si256((__m256i const*) (bRows[k] + bCol + 8));
+        __m256i inf0 = _mm256_cmpgt_epi32(b0, infinity);
+        __m256i inf1 = _mm256_cmpgt_epi32(b1, infinity);
+
+        for (int r = 0; r < GEMM_MR; ++r) {
+            int aik = aRows[r][aCol + k];
+            if (aik >= GRAPH_INFINITY) {
+                continue;
+            }
+            __m256i a = _mm256_set1_epi32(aik);
+            c[r][0] = _mm256_min_epi32(c[r][0],
+                                       _mm256_blendv_epi8(_mm256_add_epi32(a, b0), b0, inf0));
+            c[r][1] = _mm256_min_epi32(c[r][1],
+                                       _mm256_blendv_epi8(_mm256_add_epi32(a, b1), b1, inf1));
+        }
+    }
+
+    for (int r = 0; r < GEMM_MR; ++r) {
+        _mm256_storeu_si256((__m256i*) (cRows[r] + cCol), c[r][0]);
+        _mm256_storeu_si256((__m256i*) (cRows[r] + cCol + 8), c[r][1]);
+    }
+}
+
+/* A full GEMM_MR x GEMM_NR tile of C, accumulated in registers over depth. */
+static void minPlusMicroKernel(int* const* cRows, int cCol, int const* const* aRows, int aCol,
+                               int const* const* bRows, int bCol, int depth) {
+    __m256i c[GEMM_MR][2];
+
+    for (int r = 0; r < GEMM_MR; ++r) {
+        c[r][0] = _mm256_loadu_si256((__m256i const*) (cRows[r] + cCol));
+        c[r][1] = _mm256_loadu_si256((__m256i const*) (cRows[r] + cCol + 8));
+    }
+
+    for (int k = 0; k < depth; ++k) {
+        __m256i b0 = _mm256_loadu_si256((__m256i const*) (bRows[k] + bCol));
+        __m256i b1 = _mm256_loadu_si256((__m256i const*) (bRows[k] + bCol + 8));
+
+        for (int r = 0; r < GEMM_MR; ++r) {
+            __m256i a = _mm256_set1_epi32(aRows[r][aCol + k]);
+            c[r][0] = _mm256_min_epi32(c[r][0], _mm256_add_epi32(a, b0));
+            c[r][1] = _mm256_min_epi32(c[r][1], _mm256_add_epi32(a, b1));
+        }
+    }
+
+    for (int r = 0; r < GEMM_MR; ++r) {
+        _mm256_storeu_si256((__m256i*) (cRows[r] + cCol), c[r][0]);
+        _mm256_storeu_si256((__m256i*) (cRows[r] + cCol + 8), c[r][1]);
+    }
+}
+#endif
+
+/* Whether a rows x cols block has a negative element. */
+static bool hasNegative(int const* const* rows, int col, int numRows, int numCols) {
+    for (int i = 0; i < numRows; ++i) {
+        if (*std::min_element(rows[i] + col, rows[i] + col + numCols) < 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void minPlusGemm(int* const* cRows, int cCol, int const* const* aRows, int aCol,
+                 int const* const* bRows, int bCol, int M, int N, int K) {
+    for (int kb = 0; kb < K; kb += GEMM_KC) {
+        int depth = std::min(GEMM_KC, K - kb);
+        int const* const* bPanel = bRows + kb;
+#ifdef __AVX2__
+        /* Without negative terms, infinite sums stay infinite unmasked. */
+        bool absorbing = M > 0 && N > 0 &&
+            (hasNegative(aRows, aCol + kb, M, depth) || hasNegative(bPanel, bCol, depth, N));
+#endif
+
+        for (int j = 0; j < N; j += GEMM_NR) {
+            int cols = std::min(GEMM_NR, N - j);
+
+            for (int i = 0; i < M; i += GEMM_MR) {
+                int rows = std::min(GEMM_MR, M - i);
+
+#ifdef __AVX2__
+                if (rows == GEMM_MR && cols == GEMM_NR) {
+                    (absorbing ? minPlusMicroKernelAbsorbing : minPlusMicroKernel)(
+                        cRows + i, cCol + j, aRows + i, aCol + kb, bPanel, bCol + j, depth);
+                    continue;
+                }
+#endif
+                minPlusTileScalar(cRows + i, cCol + j, aRows + i, aCol + kb, bPanel, bCol + j,
+                                  rows, cols, depth);
+            }
+        }
+    }
+}
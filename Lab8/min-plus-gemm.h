@@ -0,0 +1,35 @@
+/*
+ * A blocked, register-tiled min-plus (tropical) matrix product.
+ */
+
+#ifndef __MY_MIN_PLUS_GEMM__H__
+#define __MY_MIN_PLUS_GEMM__H__
+
+/**
+ * Rows and columns of C kept in registers by the micro-kernel:
+ * 4 x 16 ints are eight AVX2 accumulators, fed by two loads
+ * of B and four broadcasts of A per step of the depth loop.
+ */
+#define GEMM_MR 4
+#define GEMM_NR 16
+
+/**
+ * Depth of a block of the product; a 256 x GEMM_NR panel
+ * of B (16 KiB) stays in L1 while a row band of C is updated.
+ */
+#define GEMM_KC 256
+
+/**
+ * C = min(C, A (x) B), where (A (x) B)[i][j] = min_k A[i][k] + B[k][j],
+ * for an M x N block C, an M x K block A and a K x N block B.
+ * Every matrix is given as row pointers and the column at which
+ * the block starts, e.g. C[i][j] is cRows[i][cCol + j], so blocks
+ * of graph fragments are used in place. No element of C may also
+ * be an element of A or B. Sums with a term at or above
+ * GRAPH_INFINITY are skipped, so infinite distances stay infinite.
+ */
+void minPlusGemm(int *const *cRows, int cCol, int const *const *aRows,
+                 int aCol, int const *const *bRows, int bCol, int M, int N,
+                 int K);
+
+#endif /* __MY_MIN_PLUS_GEMM__H__ */
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Time-to-tolerance of SOR, conjugate gradients and multigrid as N grows.
+# Every solver stops at the tolerance of Utils::getToleranceValue(N).
+
+if [ $# -lt 3 ]; then
+    >&2 echo -e "Usage: compare-solvers.sh <BUILD_DIR> <NUM_PROCESSES> <N>...\n\nWith <NUM_PROCESSES> == 0, runs laplace-seq.exe; otherwise laplace-par.exe under mpirun."
+    exit 1
+fi
+
+BUILD_DIR=$1
+NUM_PROCESSES=$2
+shift 2
+
+if [ "${NUM_PROCESSES}" -eq 0 ]; then
+    CMD="${BUILD_DIR}/laplace-seq.exe"
+else
+    CMD="mpirun ${MPIRUN_FLAGS} -np ${NUM_PROCESSES} ${BUILD_DIR}/laplace-par.exe"
+fi
+
+SOLVERS=("sor:" "cg:--cg" "cg-ssor:--cg-ssor" "mg-v:--v-cycle" "mg-w:--w-cycle")
+
+printf "%8s %10s %10s %16s\n" "N" "solver" "#iters" "duration(s)"
+
+for N in "$@"; do
+    for SOLVER in "${SOLVERS[@]}"; do
+        NAME=${SOLVER%%:*}
+        OPTION=${SOLVER#*:}
+        # Every process reports; the slowest one counts.
+        STATS=$(${CMD} ${OPTION} ${N} 2>&1 | grep "^Statistics:")
+        ITERS=$(echo "${STATS}" | sed -n 's/.*#iters=\([0-9]*\).*/\1/p' | head -n 1)
+        DURATION=$(echo "${STATS}" | sed -n 's/.*duration(s)=\([0-9.]*\).*/\1/p' | sort -g | tail -n 1)
+        printf "%8s %10s %10s %16s\n" "${N}" "${NAME}" "${ITERS:--}" "${DURATION:--}"
+    done
+done
@@ -0,0 +1,225 @@
+/*
+ * Preconditioned conjugate gradients for the Laplace
+ * problem on (distributed) grid fragments.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "laplace-common.h"
+#include "laplace-cg.h"
+
+/* The vectors of the pipelined method; x is the solution fragment itself. */
+enum CgVector { CG_R, CG_U, CG_W, CG_M, CG_N, CG_Z, CG_Q, CG_S, CG_P, CG_NUM_VECTORS };
+
+/*
+ * out = a * center + b * (sum of the four neighbors) for numPoints
+ * consecutive points of a color in a row, laid out as in relaxColorRow.
+ * out may be center.
+ */
+static void stencilColorRow(double *out,
+                            double const *center,
+                            double const *__restrict upper,
+                            double const *__restrict lower,
+                            double const *__restrict sides,
+                            int numPoints,
+                            double a,
+                            double b) {
+#pragma omp simd
+    for (int k = 0; k < numPoints; ++k) {
+        out[k] = a * center[k] + b * (upper[k] + lower[k] + sides[k] + sides[k + 1]);
+    }
+}
+
+/*
+ * The stencil on the interior points of a color of out, with the
+ * ghosts of neighbors filled. The boundary points of out are not
+ * written, so vectors created zero stay zero there.
+ */
+static void applyStencil(GridFragment *out, int color, GridFragment *center,
+                         GridFragment *neighbors, double a, double b) {
+    int bounds[4];
+
+    out->getInteriorBounds(bounds);
+    for (int rowIdx = bounds[0]; rowIdx < bounds[1]; ++rowIdx) {
+        int colIdx = bounds[2] + ((rowIdx + bounds[2]) % 2 == color ? 0 : 1);
+        if (colIdx >= bounds[3]) {
+            continue;
+        }
+        int localRowIdx = rowIdx - out->firstRowIdxIncl + 1;
+        int pointIdx = (colIdx - out->firstColIdxIncl + 2) / 2;
+        int leftIdx = pointIdx - ((colIdx - out->firstColIdxIncl) % 2 == 0 ? 1 : 0);
+
+        stencilColorRow(out->data[color][localRowIdx] + pointIdx,
+                        center->data[color][localRowIdx] + pointIdx,
+                        neighbors->data[1 - color][localRowIdx - 1] + pointIdx,
+                        neighbors->data[1 - color][localRowIdx + 1] + pointIdx,
+                        neighbors->data[1 - color][localRowIdx] + leftIdx,
+                        (bounds[3] - colIdx + 1) / 2,
+                        a,
+                        b);
+    }
+}
+
+/* out = A v, the 5-point operator on the interior points. */
+static void applyOperator(MPI_Comm comm, GridFragment *v, GridFragment *out) {
+    v->exchangeGhosts(comm);
+    for (int color = 0; color < 2; ++color) {
+        applyStencil(out, color, v, v, 4.0, -1.0);
+    }
+}
+
+/*
+ * out = M^-1 v. For SSOR, M = (D + omega L) D^-1 (D + omega U) / (omega (2 - omega))
+ * with D = 4 I and the points of color 0 ordered first: color 0 and then
+ * color 1 in the forward solve, and color 0 again in the backward one.
+ */
+static void applyPreconditioner(MPI_Comm comm, int preconditioner, GridFragment *v,
+                                GridFragment *out) {
+    if (preconditioner == CG_JACOBI) {
+        for (int color = 0; color < 2; ++color) {
+            applyStencil(out, color, v, v, 0.25, 0.0);
+        }
+        return;
+    }
+
+    double omega = CG_SSOR_OMEGA;
+    double scale = omega * (2.0 - omega) / 4.0;
+
+    applyStencil(out, 0, v, v, scale, 0.0);
+    out->exchangeGhosts(comm);
+    applyStencil(out, 1, v, out, scale, omega / 4.0);
+    out->exchangeGhosts(comm);
+    applyStencil(out, 0, out, out, 1.0, omega / 4.0);
+}
+
+/*
+ * The recurrences of an iteration over the owned points, fused with
+ * the local parts of the dot products (r, u), (w, u) and (r, r) of
+ * the updated vectors:
+ *   z = n + beta z, q = m + beta q, s = w + beta s, p = u + beta p,
+ *   x += alpha p, r -= alpha s, u -= alpha q, w -= alpha z.
+ * With update false, only the dot products are computed.
+ */
+static void updateVectors(GridFragment *x, GridFragment **vectors, double alpha, double beta,
+                          bool update, double *dots) {
+    double ru = 0.0;
+    double wu = 0.0;
+    double rr = 0.0;
+
+    for (int rowIdx = x->firstRowIdxIncl; rowIdx < x->lastRowIdxExcl; ++rowIdx) {
+        int localRowIdx = rowIdx - x->firstRowIdxIncl + 1;
+
+        for (int color = 0; color < 2; ++color) {
+            int numPoints = x->getNumColorPointsInRow(rowIdx, color);
+            double *v[CG_NUM_VECTORS];
+            for (int vec = 0; vec < CG_NUM_VECTORS; ++vec) {
+                v[vec] = vectors[vec]->data[color][localRowIdx] + 1;
+            }
+            double *__restrict xs = x->data[color][localRowIdx] + 1;
+            double *__restrict r = v[CG_R];
+            double *__restrict u = v[CG_U];
+            double *__restrict w = v[CG_W];
+            double const *__restrict m = v[CG_M];
+            double const *__restrict n = v[CG_N];
+            double *__restrict z = v[CG_Z];
+            double *__restrict q = v[CG_Q];
+            double *__restrict s = v[CG_S];
+            double *__restrict p = v[CG_P];
+
+            if (update) {
+#pragma omp simd reduction(+ : ru, wu, rr)
+                for (int k = 0; k < numPoints; ++k) {
+                    z[k] = n[k] + beta * z[k];
+                    q[k] = m[k] + beta * q[k];
+                    s[k] = w[k] + beta * s[k];
+                    p[k] = u[k] + beta * p[k];
+                    xs[k] += alpha * p[k];
+                    r[k] -= alpha * s[k];
+                    u[k] -= alpha * q[k];
+                    w[k] -= alpha * z[k];
+                    ru += r[k] * u[k];
+                    wu += w[k] * u[k];
+                    rr += r[k] * r[k];
+                }
+            } else {
+#pragma omp simd reduction(+ : ru, wu, rr)
+                for (int k = 0; k < numPoints; ++k) {
+                    ru += r[k] * u[k];
+                    wu += w[k] * u[k];
+                    rr += r[k] * r[k];
+                }
+            }
+        }
+    }
+
+    dots[0] = ru;
+    dots[1] = wu;
+    dots[2] = rr;
+}
+
+std::tuple<int, double> runConjugateGradient(MPI_Comm gridComm, GridFragment *frag,
+                                             int preconditioner, double epsilon) {
+    GridFragment *vectors[CG_NUM_VECTORS];
+    for (int vec = 0; vec < CG_NUM_VECTORS; ++vec) {
+        vectors[vec] = new GridFragment(frag->gridDimension, frag->firstRowIdxIncl,
+                                        frag->lastRowIdxExcl, frag->firstColIdxIncl,
+                                        frag->lastColIdxExcl);
+    }
+    GridFragment *r = vectors[CG_R];
+    GridFragment *u = vectors[CG_U];
+    GridFragment *w = vectors[CG_W];
+
+    /* r = 0 - A x: the boundary values move to the right-hand side. */
+    frag->exchangeGhosts(gridComm);
+    for (int color = 0; color < 2; ++color) {
+        applyStencil(r, color, frag, frag, -4.0, 1.0);
+    }
+    applyPreconditioner(gridComm, preconditioner, r, u);
+    applyOperator(gridComm, u, w);
+
+    double localDots[3];
+    double dots[3];
+    double alpha = 0.0;
+    double prevGamma = 0.0;
+    double residualNorm = 0.0;
+    int numIterations = 0;
+
+    updateVectors(frag, vectors, 0.0, 0.0, false, localDots);
+
+    while (true) {
+        MPI_Request reduceRequest = MPI_REQUEST_NULL;
+        if (gridComm != MPI_COMM_NULL) {
+            MPI_Iallreduce(localDots, dots, 3, MPI_DOUBLE, MPI_SUM, gridComm, &reduceRequest);
+        } else {
+            std::copy(localDots, localDots + 3, dots);
+        }
+
+        /* m = M^-1 w and n = A m while the dot products are reduced. */
+        applyPreconditioner(gridComm, preconditioner, w, vectors[CG_M]);
+        applyOperator(gridComm, vectors[CG_M], vectors[CG_N]);
+
+        if (gridComm != MPI_COMM_NULL) {
+            MPI_Wait(&reduceRequest, MPI_STATUS_IGNORE);
+        }
+
+        double gamma = dots[0];
+        double delta = dots[1];
+        residualNorm = sqrt(dots[2]) / 4.0;
+        if (residualNorm <= epsilon || delta == 0.0) {
+            break;
+        }
+
+        double beta = numIterations == 0 ? 0.0 : gamma / prevGamma;
+        alpha = numIterations == 0 ? gamma / delta : gamma / (delta - beta * gamma / alpha);
+        prevGamma = gamma;
+
+        updateVectors(frag, vectors, alpha, beta, true, localDots);
+        ++numIterations;
+    }
+
+    for (auto vector : vectors) {
+        vector->free();
+    }
+
+    return std::make_tuple(numIterations, residualNorm);
+}
@@ -0,0 +1,49 @@
+/*
+ * Preconditioned conjugate gradients for the Laplace
+ * problem on (distributed) grid fragments.
+ */
+
+#ifndef __LAPLACE_CG_H__
+#define __LAPLACE_CG_H__
+
+#include <mpi.h>
+#include <tuple>
+#include "laplace-common.h"
+
+/**
+ * Jacobi preconditioning only scales by the constant
+ * diagonal, 1 / 4, and converges as plain CG does.
+ * Red-black SSOR applies a forward and a backward
+ * red-black sweep, each after a ghost exchange.
+ */
+#define CG_JACOBI 1
+#define CG_SSOR 2
+
+/**
+ * The relaxation factor of the SSOR preconditioner;
+ * with the red-black ordering, over-relaxing only
+ * makes the preconditioner worse.
+ */
+#define CG_SSOR_OMEGA 1.0
+
+/**
+ * Solves the Laplace problem on frag, whose boundary points
+ * hold the boundary values, by pipelined preconditioned
+ * conjugate gradients on the interior points, with the
+ * matrix-free 5-point operator 4 u(i, j) - (sum of the four
+ * neighbors). preconditioner is CG_JACOBI or CG_SSOR. The three
+ * dot products of an iteration go into a single non-blocking
+ * reduction that runs during its preconditioner and operator
+ * applications. Iterations stop once the 2-norm of the residual,
+ * divided by 4, is at most epsilon; that bounds the largest change
+ * a Gauss-Seidel update would make, as for the other solvers.
+ * gridComm is the Cartesian communicator of the processes sharing
+ * the grid, or MPI_COMM_NULL if frag is the whole grid (and MPI is
+ * not used at all). Returns the number of iterations and that value.
+ */
+std::tuple<int, double> runConjugateGradient(MPI_Comm gridComm,
+                                             GridFragment *frag,
+                                             int preconditioner,
+                                             double epsilon);
+
+#endif /* __LAPLACE_CG_H__ */
@@ -0,0 +1,155 @@
+/*
+ * Checkpoints of a distributed grid in a single file,
+ * written and read with collective MPI-IO.
+ */
+
+#include <cstring>
+#include "laplace-common.h"
+#include "laplace-checkpoint.h"
+
+static int getNumOwnedPoints(GridFragment *frag) {
+    return (frag->lastRowIdxExcl - frag->firstRowIdxIncl) *
+            (frag->lastColIdxExcl - frag->firstColIdxIncl);
+}
+
+/* Whether header describes a complete checkpoint of a grid of numPointsPerDimension points. */
+static bool isValidHeader(CheckpointHeader const &header, int numPointsPerDimension) {
+    return memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+            header.numPointsPerDimension == numPointsPerDimension &&
+            (header.slot == 0 || header.slot == 1);
+}
+
+static CheckpointHeader readHeader(MPI_File file) {
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    MPI_File_read_at_all(file, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+    return header;
+}
+
+void Checkpoint::setSlotView(MPI_File file, MPI_Datatype blockType, MPI_Offset slotSize, int slot) {
+    MPI_File_set_view(file, CHECKPOINT_HEADER_SIZE + slot * slotSize, MPI_DOUBLE, blockType,
+                      "native", MPI_INFO_NULL);
+}
+
+Checkpoint *Checkpoint::create(MPI_Comm gridComm, GridFragment *frag, char const *path,
+                               int interval) {
+    MPI_File file;
+
+    if (MPI_File_open(gridComm, path, MPI_MODE_CREATE | MPI_MODE_RDWR, MPI_INFO_NULL,
+                      &file) != MPI_SUCCESS) {
+        return nullptr;
+    }
+
+    return new Checkpoint(gridComm, frag, file, interval);
+}
+
+Checkpoint::Checkpoint(MPI_Comm gridComm, GridFragment *frag, MPI_File file, int interval) :
+        gridComm(gridComm),
+        file(file),
+        blockType(frag->createOwnedBlockFileType()),
+        slotSize((MPI_Offset) frag->gridDimension * frag->gridDimension * sizeof(double)),
+        interval(interval),
+        nextSlot(0),
+        request(MPI_REQUEST_NULL),
+        writing(false) {
+    for (int slot = 0; slot < 2; ++slot) {
+        this->staging[slot].resize(getNumOwnedPoints(frag));
+    }
+
+    /* Never overwrite the last checkpoint in the file, e.g. the one restarted from. */
+    CheckpointHeader header = readHeader(file);
+    if (isValidHeader(header, frag->gridDimension)) {
+        this->nextSlot = 1 - (int) header.slot;
+    }
+    memset(&this->pendingHeader, 0, sizeof(this->pendingHeader));
+}
+
+void Checkpoint::saveIfDue(GridFragment *frag, int numIterations, double maxDiff) {
+    if (this->writing && numIterations % CHECKPOINT_POLL_INTERVAL == 0) {
+        int isComplete;
+        MPI_Test(&this->request, &isComplete, MPI_STATUS_IGNORE);
+        MPI_Allreduce(MPI_IN_PLACE, &isComplete, 1, MPI_INT, MPI_LAND, this->gridComm);
+        if (isComplete) {
+            this->completePending();
+        }
+    }
+
+    if (numIterations % this->interval != 0) {
+        return;
+    }
+
+    /* The other staging buffer may still be written out. */
+    int slot = this->nextSlot;
+    frag->packOwnedPoints(this->staging[slot].data());
+
+    this->completePending();
+
+    setSlotView(this->file, this->blockType, this->slotSize, slot);
+    MPI_File_iwrite_all(this->file, this->staging[slot].data(), (int) this->staging[slot].size(),
+                        MPI_DOUBLE, &this->request);
+    this->writing = true;
+
+    memcpy(this->pendingHeader.magic, CHECKPOINT_MAGIC, sizeof(this->pendingHeader.magic));
+    this->pendingHeader.numPointsPerDimension = frag->gridDimension;
+    this->pendingHeader.slot = slot;
+    this->pendingHeader.numIterations = numIterations;
+    this->pendingHeader.maxDiff = maxDiff;
+    this->nextSlot = 1 - slot;
+}
+
+void Checkpoint::completePending() {
+    if (!this->writing) {
+        return;
+    }
+
+    int myRank;
+    MPI_Comm_rank(this->gridComm, &myRank);
+
+    MPI_Wait(&this->request, MPI_STATUS_IGNORE);
+    /* The slot must be on disk before the header points at it. */
+    MPI_File_sync(this->file);
+    MPI_File_set_view(this->file, 0, MPI_BYTE, MPI_BYTE, "native", MPI_INFO_NULL);
+    if (myRank == 0) {
+        MPI_File_write_at(this->file, 0, &this->pendingHeader, sizeof(this->pendingHeader),
+                          MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    this->writing = false;
+}
+
+void Checkpoint::close() {
+    this->completePending();
+    MPI_File_sync(this->file);
+    MPI_File_close(&this->file);
+    MPI_Type_free(&this->blockType);
+    delete(this);
+}
+
+int Checkpoint::restore(MPI_Comm gridComm, GridFragment *frag, char const *path,
+                        int *numIterations, double *maxDiff) {
+    MPI_File file;
+
+    if (MPI_File_open(gridComm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        return 1;
+    }
+
+    CheckpointHeader header = readHeader(file);
+    if (!isValidHeader(header, frag->gridDimension)) {
+        MPI_File_close(&file);
+        return 2;
+    }
+
+    /* The block of this process, whatever the blocks of the writers were. */
+    MPI_Datatype blockType = frag->createOwnedBlockFileType();
+    std::vector<double> block(getNumOwnedPoints(frag));
+    setSlotView(file, blockType, (MPI_Offset) frag->gridDimension * frag->gridDimension * sizeof(double),
+                (int) header.slot);
+    MPI_File_read_all(file, block.data(), (int) block.size(), MPI_DOUBLE, MPI_STATUS_IGNORE);
+    frag->unpackOwnedPoints(block.data());
+
+    MPI_Type_free(&blockType);
+    MPI_File_close(&file);
+
+    *numIterations = (int) header.numIterations;
+    *maxDiff = header.maxDiff;
+    return 0;
+}
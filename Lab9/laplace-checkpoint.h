@@ -0,0 +1,111 @@
+/*
+ * Checkpoints of a distributed grid in a single file,
+ * written and read with collective MPI-IO.
+ */
+
+#ifndef __LAPLACE_CHECKPOINT_H__
+#define __LAPLACE_CHECKPOINT_H__
+
+#include <cstdint>
+#include <mpi.h>
+#include <vector>
+#include "laplace-common.h"
+
+#define CHECKPOINT_MAGIC "LAPLACE1"
+#define CHECKPOINT_INTERVAL_DEFAULT 1000
+
+/**
+ * While a checkpoint is being written, the processes agree every
+ * this many iterations whether it is complete at all of them, and
+ * if so point the header at it. A checkpoint thus becomes the one
+ * to restart from at most this many iterations after its write
+ * completes, not only once the next one is started.
+ */
+#define CHECKPOINT_POLL_INTERVAL 8
+
+/**
+ * The file starts with a header padded to CHECKPOINT_HEADER_SIZE
+ * bytes and holds two slots, each the whole grid as N x N doubles
+ * in row order. Checkpoints go to the slots in turns, and the
+ * header is rewritten to point at a slot only once it is complete
+ * on disk, so a failure during a write leaves the last checkpoint
+ * intact. Any number of processes can read a slot back.
+ */
+#define CHECKPOINT_HEADER_SIZE 64
+
+struct CheckpointHeader {
+    char magic[8];
+    int64_t numPointsPerDimension;
+    int64_t slot;
+    int64_t numIterations;
+    double maxDiff;
+};
+
+class Checkpoint {
+public:
+    /**
+     * Opens (or creates) the checkpoint file for the fragments
+     * of the processes of gridComm, collectively. Returns
+     * nullptr if the file cannot be opened.
+     */
+    static Checkpoint *create(MPI_Comm gridComm,
+                              GridFragment *frag,
+                              char const *path,
+                              int interval);
+
+    /**
+     * Reads the owned points of frag from the last checkpoint
+     * in the file, collectively, whatever the number of processes
+     * that wrote it; the ghosts are left alone. Returns 0, or 1
+     * if the file cannot be read, 2 if it holds no checkpoint of
+     * a grid of this size.
+     */
+    static int restore(MPI_Comm gridComm,
+                       GridFragment *frag,
+                       char const *path,
+                       int *numIterations,
+                       double *maxDiff);
+
+    /**
+     * To be called after every iteration. If numIterations is a
+     * multiple of the interval, copies the owned points of frag to
+     * a staging buffer and starts writing them in the background;
+     * the solver may then go on modifying frag. Waits only for the
+     * checkpoint before, which had the whole interval to complete.
+     * Otherwise, every CHECKPOINT_POLL_INTERVAL iterations, publishes
+     * the checkpoint being written if it is complete. Collective.
+     */
+    void saveIfDue(GridFragment *frag,
+                   int numIterations,
+                   double maxDiff);
+
+    /**
+     * Completes the last checkpoint, closes
+     * the file and frees the object. Collective.
+     */
+    void close();
+
+private:
+    MPI_Comm gridComm;
+    MPI_File file;
+    MPI_Datatype blockType;
+    MPI_Offset slotSize;
+    int interval;
+    int nextSlot;
+    std::vector<double> staging[2];
+    MPI_Request request;
+    bool writing;
+    CheckpointHeader pendingHeader;
+
+    Checkpoint(MPI_Comm gridComm, GridFragment *frag, MPI_File file, int interval);
+
+    /**
+     * Waits for the write in flight, if any, and then
+     * points the header at its slot. Collective.
+     */
+    void completePending();
+
+    static void setSlotView(MPI_File file, MPI_Datatype blockType, MPI_Offset slotSize, int slot);
+};
+
+#endif /* __LAPLACE_CHECKPOINT_H__ */
@@ -9,6 +9,11 @@
 #import <mpi.h>
 #import <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <charconv>
+#include <vector>
 
 #define LAPLACE_I0 1.56
 #define LAPLACE_IN 10.85
@@ -16,6 +21,10 @@
 #define LAPLACE_JN 3.88
 #define LAPLACE_XX 0.0
 
+/* Enough for any double in fixed notation with GRID_TEXT_PRECISION digits. */
+#define GRID_TEXT_MAX_VALUE_CHARS 400
+#define GRID_TEXT_PRECISION 5
+
 double Utils::getInitialValue(int i, int j, int numPointsPerDimension) {
     if (i == 0) {
         return LAPLACE_I0;
@@ -51,6 +60,38 @@ int InputOptions::getErrorCode() {
     return this->errorCode;
 }
 
+bool InputOptions::isConvergenceCheckAmortized() {
+    return this->amortizedConvergenceCheck;
+}
+
+int InputOptions::getMultigridCycleIndex() {
+    return this->multigridCycleIndex;
+}
+
+int InputOptions::getCgPreconditioner() {
+    return this->cgPreconditioner;
+}
+
+char const *InputOptions::getCheckpointPath() {
+    return this->checkpointPath;
+}
+
+int InputOptions::getCheckpointInterval() {
+    return this->checkpointInterval;
+}
+
+char const *InputOptions::getRestartPath() {
+    return this->restartPath;
+}
+
+char const *InputOptions::getOutputPath() {
+    return this->outputPath;
+}
+
+char const *InputOptions::getTextOutputPath() {
+    return this->textOutputPath;
+}
+
 int GridFragment::getFirstRowIdxOwnedByProcess(
         int numPointsPerDimension,
         int numProcesses,
@@ -62,38 +103,71 @@ int GridFragment::getFirstRowIdxOwnedByProcess(
     return idx;
 }
 
-GridFragment::GridFragment(int numPointsPerDimension, int numProcesses, int myRank, bool debug) {
+GridFragment::GridFragment(int numPointsPerDimension, int numProcesses, int myRank, bool debug) :
+        GridFragment(numPointsPerDimension,
+                     std::array<int, 2>{{numProcesses, 1}}.data(),
+                     std::array<int, 2>{{myRank, 0}}.data(),
+                     debug) {}
+
+GridFragment::GridFragment(
+        int numPointsPerDimension,
+        int const *processGridDims,
+        int const *myCoords,
+        bool debug
+) :
+        GridFragment(numPointsPerDimension,
+                     getFirstRowIdxOwnedByProcess(numPointsPerDimension, processGridDims[0], myCoords[0]),
+                     getFirstRowIdxOwnedByProcess(numPointsPerDimension, processGridDims[0], myCoords[0] + 1),
+                     getFirstRowIdxOwnedByProcess(numPointsPerDimension, processGridDims[1], myCoords[1]),
+                     getFirstRowIdxOwnedByProcess(numPointsPerDimension, processGridDims[1], myCoords[1] + 1),
+                     debug) {
+    assert(numPointsPerDimension >= processGridDims[0]);
+    assert(numPointsPerDimension >= processGridDims[1]);
+    this->numProcessRows = processGridDims[0];
+    this->numProcessCols = processGridDims[1];
+}
+
+GridFragment::GridFragment(
+        int numPointsPerDimension,
+        int firstRowIdxIncl,
+        int lastRowIdxExcl,
+        int firstColIdxIncl,
+        int lastColIdxExcl,
+        bool debug
+) {
     int color, i;
     int maxPointsPerColorPerRow;
     int numTotalRows;
 
-    assert(numPointsPerDimension >= numProcesses);
     for (color = 0; color < 2; ++color) {
         this->data[color] = nullptr;
+        this->storage[color] = nullptr;
     }
 
     this->extraRowForPrinting = nullptr;
     this->gridDimension = numPointsPerDimension;
-    this->firstRowIdxIncl = this->getFirstRowIdxOwnedByProcess(
-            numPointsPerDimension,
-            numProcesses,
-            myRank);
-    this->lastRowIdxExcl = this->getFirstRowIdxOwnedByProcess(
-            numPointsPerDimension,
-            numProcesses,
-            myRank + 1);
+    this->numProcessRows = 1;
+    this->numProcessCols = 1;
+    this->firstRowIdxIncl = firstRowIdxIncl;
+    this->lastRowIdxExcl = lastRowIdxExcl;
+    this->firstColIdxIncl = firstColIdxIncl;
+    this->lastColIdxExcl = lastColIdxExcl;
     numTotalRows = this->lastRowIdxExcl - this->firstRowIdxIncl + 2;
-    maxPointsPerColorPerRow = (numPointsPerDimension + 1) / 2;
+    /* Column j is at index (j - firstColIdxIncl + 2) / 2, see GP. */
+    maxPointsPerColorPerRow = (this->lastColIdxExcl - this->firstColIdxIncl + 2) / 2 + 1;
 
     if (debug) {
         std::cerr <<
-                  "DBG PROCESS " << myRank
-                  << ": GD="
+                  "DBG FRAGMENT: GD="
                   << this->gridDimension
                   << " FR="
                   << this->firstRowIdxIncl
                   << " LR="
                   << this->lastRowIdxExcl
+                  << " FC="
+                  << this->firstColIdxIncl
+                  << " LC="
+                  << this->lastColIdxExcl
                   << " TR="
                   << numTotalRows
                   << " MPPCPR="
@@ -101,19 +175,23 @@ GridFragment::GridFragment(int numPointsPerDimension, int numProcesses, int myRa
                   << std::endl;
     }
 
+    /* Rows of a color are views into one block, each padded to whole cache lines. */
+    this->rowStride = (maxPointsPerColorPerRow + GRID_ROW_ALIGNMENT / sizeof(double) - 1) /
+            (GRID_ROW_ALIGNMENT / sizeof(double)) * (GRID_ROW_ALIGNMENT / sizeof(double));
+
     for (color = 0; color < 2; ++color) {
+        void *block = nullptr;
+        this->storage[color] = nullptr;
         this->data[color] = new double*[numTotalRows];
-        if (this->data[color] == nullptr) {
+        if (posix_memalign(&block, GRID_ROW_ALIGNMENT,
+                           sizeof(double) * numTotalRows * this->rowStride) != 0) {
             this->free();
+            return;
         }
+        this->storage[color] = (double *) block;
+        std::fill(this->storage[color], this->storage[color] + (size_t) numTotalRows * this->rowStride, 0.0);
         for (i = 0; i < numTotalRows; ++i) {
-            this->data[color][i] = nullptr;
-        }
-        for (i = 0; i < numTotalRows; ++i) {
-            this->data[color][i] = new double[maxPointsPerColorPerRow]; 
-            if (this->data[color][i] == nullptr) {
-                this->free();
-            }
+            this->data[color][i] = this->storage[color] + (size_t) i * this->rowStride;
         }
     }
 
@@ -124,17 +202,15 @@ GridFragment::GridFragment(int numPointsPerDimension, int numProcesses, int myRa
 }
 
 void GridFragment::free() {
-    int numOwnedRows = this->lastRowIdxExcl - this->firstRowIdxIncl + 2;
     for (int color = 0; color < 2; ++color) {
         if (this->data[color] != nullptr) {
-            for (int i = 0; i < numOwnedRows; ++i) {
-                if (this->data[color][i] != nullptr) {
-                    delete(this->data[color][i]);
-                }
-            }
-            delete(this->data[color]);
+            delete[] this->data[color];
             this->data[color] = nullptr;
         }
+        if (this->storage[color] != nullptr) {
+            ::free(this->storage[color]);
+            this->storage[color] = nullptr;
+        }
     }
 
     if (this->extraRowForPrinting != nullptr) {
@@ -148,46 +224,60 @@ void GridFragment::printEntireGrid(
         int myRank,
         int numProcesses
 ) {
+    assert(numProcesses == this->numProcessRows * this->numProcessCols);
+    int numOwnedCols = this->lastColIdxExcl - this->firstColIdxIncl;
+
     if (myRank == 0) {
         MPI_Status status;
-        int rowIdx = 0;
-        for (rowIdx = this->firstRowIdxIncl; rowIdx < this->lastRowIdxExcl; ++rowIdx) {
-            std::cout << std::fixed << std::setprecision(5) << GP(this, rowIdx, 0);
-            for (int colIdx = 1; colIdx < this->gridDimension; ++colIdx) {
-                std::cout << " " << std::fixed << std::setprecision(5) << GP(this, rowIdx, colIdx);
-            }
-            std::cout << std::endl;
-        }
-        for (int procIdx = 1; procIdx < numProcesses; ++procIdx) {
-            int lastIdx = this->getFirstRowIdxOwnedByProcess(
+        int procRow = 0;
+        for (int rowIdx = 0; rowIdx < this->gridDimension; ++rowIdx) {
+            while (rowIdx == this->getFirstRowIdxOwnedByProcess(
                     this->gridDimension,
-                    numProcesses,
-                    procIdx + 1);
-            for (; rowIdx < lastIdx; ++rowIdx) {
-                MPI_Recv(
-                        this->extraRowForPrinting,
+                    this->numProcessRows,
+                    procRow + 1)) {
+                ++procRow;
+            }
+            /* Row segments come from the processes of a row of the process grid, in order. */
+            for (int procCol = 0; procCol < this->numProcessCols; ++procCol) {
+                int procIdx = procRow * this->numProcessCols + procCol;
+                int firstColIdx = this->getFirstRowIdxOwnedByProcess(
+                        this->gridDimension,
+                        this->numProcessCols,
+                        procCol);
+                int lastColIdx = this->getFirstRowIdxOwnedByProcess(
                         this->gridDimension,
-                        MPI_DOUBLE,
-                        procIdx,
-                        PRINT_MSG_TAG,
-                        MPI_COMM_WORLD,
-                        &status
-                );
-                std::cout << std::fixed << std::setprecision(5) << this->extraRowForPrinting[0];
-                for (int colIdx = 1; colIdx < this->gridDimension; ++colIdx) {
-                    std::cout << " " << std::fixed << std::setprecision(5) << this->extraRowForPrinting[colIdx];
+                        this->numProcessCols,
+                        procCol + 1);
+                if (procIdx == 0) {
+                    for (int colIdx = firstColIdx; colIdx < lastColIdx; ++colIdx) {
+                        this->extraRowForPrinting[colIdx] = GP(this, rowIdx, colIdx);
+                    }
+                } else {
+                    MPI_Recv(
+                            this->extraRowForPrinting + firstColIdx,
+                            lastColIdx - firstColIdx,
+                            MPI_DOUBLE,
+                            procIdx,
+                            PRINT_MSG_TAG,
+                            MPI_COMM_WORLD,
+                            &status
+                    );
                 }
-                std::cout << std::endl;
             }
+            std::cout << std::fixed << std::setprecision(5) << this->extraRowForPrinting[0];
+            for (int colIdx = 1; colIdx < this->gridDimension; ++colIdx) {
+                std::cout << " " << std::fixed << std::setprecision(5) << this->extraRowForPrinting[colIdx];
+            }
+            std::cout << std::endl;
         }
     } else {
         for (int rowIdx = this->firstRowIdxIncl; rowIdx < this->lastRowIdxExcl; ++rowIdx) {
-            for (int colIdx = 0; colIdx < this->gridDimension; ++colIdx) {
-                this->extraRowForPrinting[colIdx] = GP(this, rowIdx, colIdx);
+            for (int colIdx = this->firstColIdxIncl; colIdx < this->lastColIdxExcl; ++colIdx) {
+                this->extraRowForPrinting[colIdx - this->firstColIdxIncl] = GP(this, rowIdx, colIdx);
             }
             MPI_Send(
                     this->extraRowForPrinting,
-                    this->gridDimension,
+                    numOwnedCols,
                     MPI_DOUBLE,
                     0,
                     PRINT_MSG_TAG,
@@ -197,9 +287,143 @@ void GridFragment::printEntireGrid(
     }
 }
 
+int GridFragment::writeEntireGrid(MPI_Comm comm, char const *path) {
+    MPI_File file;
+
+    if (MPI_File_open(comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                      &file) != MPI_SUCCESS) {
+        return 1;
+    }
+    MPI_File_set_size(file, 0);
+
+    std::vector<double> block((size_t) (this->lastRowIdxExcl - this->firstRowIdxIncl) *
+                              (this->lastColIdxExcl - this->firstColIdxIncl));
+    this->packOwnedPoints(block.data());
+
+    MPI_Datatype blockType = this->createOwnedBlockFileType();
+    MPI_File_set_view(file, 0, MPI_DOUBLE, blockType, "native", MPI_INFO_NULL);
+    MPI_File_write_all(file, block.data(), (int) block.size(), MPI_DOUBLE, MPI_STATUS_IGNORE);
+
+    MPI_Type_free(&blockType);
+    MPI_File_close(&file);
+    return 0;
+}
+
+int GridFragment::writeEntireGridText(MPI_Comm comm, char const *path) {
+    int numOwnedRows = this->lastRowIdxExcl - this->firstRowIdxIncl;
+    std::vector<char> text;
+    std::vector<long long> segmentLengths(numOwnedRows);
+    char value[GRID_TEXT_MAX_VALUE_CHARS];
+
+    /* The segment of each owned row: values followed by a space, or a newline at the end of the row. */
+    text.reserve((size_t) numOwnedRows * (this->lastColIdxExcl - this->firstColIdxIncl) * 8);
+    for (int rowIdx = this->firstRowIdxIncl; rowIdx < this->lastRowIdxExcl; ++rowIdx) {
+        size_t segmentStart = text.size();
+        for (int colIdx = this->firstColIdxIncl; colIdx < this->lastColIdxExcl; ++colIdx) {
+            auto result = std::to_chars(value, value + sizeof(value), GP(this, rowIdx, colIdx),
+                                        std::chars_format::fixed, GRID_TEXT_PRECISION);
+            text.insert(text.end(), value, result.ptr);
+            text.push_back(colIdx == this->gridDimension - 1 ? '\n' : ' ');
+        }
+        segmentLengths[rowIdx - this->firstRowIdxIncl] = (long long) (text.size() - segmentStart);
+    }
+
+    /*
+     * Offsets: segments to the left come from the processes before in
+     * the same row of the process grid, rows above from the processes
+     * before in the same column.
+     */
+    MPI_Comm rowComm, colComm;
+    int keepCols[2] = {0, 1};
+    int keepRows[2] = {1, 0};
+    int rankInRow, rankInCol;
+    MPI_Cart_sub(comm, keepCols, &rowComm);
+    MPI_Cart_sub(comm, keepRows, &colComm);
+    MPI_Comm_rank(rowComm, &rankInRow);
+    MPI_Comm_rank(colComm, &rankInCol);
+
+    std::vector<long long> offsetsInRow(numOwnedRows, 0);
+    std::vector<long long> rowLengths(numOwnedRows);
+    MPI_Exscan(segmentLengths.data(), offsetsInRow.data(), numOwnedRows, MPI_LONG_LONG, MPI_SUM,
+               rowComm);
+    if (rankInRow == 0) {
+        std::fill(offsetsInRow.begin(), offsetsInRow.end(), 0);
+    }
+    MPI_Allreduce(segmentLengths.data(), rowLengths.data(), numOwnedRows, MPI_LONG_LONG, MPI_SUM,
+                  rowComm);
+
+    long long bandLength = 0;
+    long long bandOffset = 0;
+    for (int localRowIdx = 0; localRowIdx < numOwnedRows; ++localRowIdx) {
+        bandLength += rowLengths[localRowIdx];
+    }
+    MPI_Exscan(&bandLength, &bandOffset, 1, MPI_LONG_LONG, MPI_SUM, colComm);
+    if (rankInCol == 0) {
+        bandOffset = 0;
+    }
+
+    std::vector<int> blockLengths(numOwnedRows);
+    std::vector<MPI_Aint> displacements(numOwnedRows);
+    long long rowOffset = bandOffset;
+    for (int localRowIdx = 0; localRowIdx < numOwnedRows; ++localRowIdx) {
+        blockLengths[localRowIdx] = (int) segmentLengths[localRowIdx];
+        displacements[localRowIdx] = (MPI_Aint) (rowOffset + offsetsInRow[localRowIdx]);
+        rowOffset += rowLengths[localRowIdx];
+    }
+
+    MPI_Comm_free(&rowComm);
+    MPI_Comm_free(&colComm);
+
+    MPI_File file;
+    if (MPI_File_open(comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                      &file) != MPI_SUCCESS) {
+        return 1;
+    }
+    MPI_File_set_size(file, 0);
+
+    MPI_Datatype segmentsType;
+    MPI_Type_create_hindexed(numOwnedRows, blockLengths.data(), displacements.data(), MPI_CHAR,
+                             &segmentsType);
+    MPI_Type_commit(&segmentsType);
+    MPI_File_set_view(file, 0, MPI_CHAR, segmentsType, "native", MPI_INFO_NULL);
+    MPI_File_write_all(file, text.data(), (int) text.size(), MPI_CHAR, MPI_STATUS_IGNORE);
+
+    MPI_Type_free(&segmentsType);
+    MPI_File_close(&file);
+    return 0;
+}
+
+MPI_Datatype GridFragment::createOwnedBlockFileType() {
+    int sizes[2] = {this->gridDimension, this->gridDimension};
+    int subsizes[2] = {this->lastRowIdxExcl - this->firstRowIdxIncl,
+                       this->lastColIdxExcl - this->firstColIdxIncl};
+    int starts[2] = {this->firstRowIdxIncl, this->firstColIdxIncl};
+    MPI_Datatype blockType;
+
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_DOUBLE, &blockType);
+    MPI_Type_commit(&blockType);
+    return blockType;
+}
+
+void GridFragment::packOwnedPoints(double *block) {
+    for (int rowIdx = this->firstRowIdxIncl; rowIdx < this->lastRowIdxExcl; ++rowIdx) {
+        for (int colIdx = this->firstColIdxIncl; colIdx < this->lastColIdxExcl; ++colIdx) {
+            *block++ = GP(this, rowIdx, colIdx);
+        }
+    }
+}
+
+void GridFragment::unpackOwnedPoints(double const *block) {
+    for (int rowIdx = this->firstRowIdxIncl; rowIdx < this->lastRowIdxExcl; ++rowIdx) {
+        for (int colIdx = this->firstColIdxIncl; colIdx < this->lastColIdxExcl; ++colIdx) {
+            GP(this, rowIdx, colIdx) = *block++;
+        }
+    }
+}
+
 void GridFragment::initialize() {
     for (int rowIdx = this->firstRowIdxIncl; rowIdx < this->lastRowIdxExcl; ++rowIdx) {
-        for (int colIdx = 0; colIdx < this->gridDimension; ++colIdx) {
+        for (int colIdx = this->firstColIdxIncl; colIdx < this->lastColIdxExcl; ++colIdx) {
             GP(this, rowIdx, colIdx) = Utils::getInitialValue(rowIdx, colIdx, this->gridDimension);
         }
     }
@@ -208,7 +432,154 @@ void GridFragment::initialize() {
 int GridFragment::getNumColorPointsInRow(
         int rowIdx,
         int color) {
-    int base = this->gridDimension / 2;
-    int remainder = this->gridDimension % 2;
-    return base + remainder * (rowIdx % 2 == color ? 1 : 0);
+    int numCols = this->lastColIdxExcl - this->firstColIdxIncl;
+    int base = numCols / 2;
+    int remainder = numCols % 2;
+    return base + remainder * ((rowIdx + this->firstColIdxIncl) % 2 == color ? 1 : 0);
+}
+
+int GridFragment::getNumColorPointsInCol(
+        int colIdx,
+        int color) {
+    int numRows = this->lastRowIdxExcl - this->firstRowIdxIncl;
+    int base = numRows / 2;
+    int remainder = numRows % 2;
+    return base + remainder * ((colIdx + this->firstRowIdxIncl) % 2 == color ? 1 : 0);
+}
+
+double GridFragment::relaxBlock(
+        int color,
+        int startRowIncl,
+        int endRowExcl,
+        int startColIncl,
+        int endColExcl,
+        double omega,
+        GridFragment *rhs) {
+    double maxDiff = 0.0;
+
+    for (int rowIdx = startRowIncl; rowIdx < endRowExcl; ++rowIdx) {
+        int colIdx = startColIncl + ((rowIdx + startColIncl) % 2 == color ? 0 : 1);
+        if (colIdx >= endColExcl) {
+            continue;
+        }
+        int localRowIdx = rowIdx - this->firstRowIdxIncl + 1;
+        int pointIdx = (colIdx - this->firstColIdxIncl + 2) / 2;
+        /* Points at an even offset from the ghost column sit right of their left neighbor. */
+        int leftIdx = pointIdx - ((colIdx - this->firstColIdxIncl) % 2 == 0 ? 1 : 0);
+
+        double diff = relaxColorRow(
+                this->data[color][localRowIdx] + pointIdx,
+                this->data[1 - color][localRowIdx - 1] + pointIdx,
+                this->data[1 - color][localRowIdx + 1] + pointIdx,
+                this->data[1 - color][localRowIdx] + leftIdx,
+                rhs != nullptr ? rhs->data[color][localRowIdx] + pointIdx : nullptr,
+                (endColExcl - colIdx + 1) / 2,
+                omega);
+        maxDiff = std::max(maxDiff, diff);
+    }
+
+    return maxDiff;
+}
+
+double GridFragment::relaxColorRow(
+        double *__restrict points,
+        double const *__restrict upper,
+        double const *__restrict lower,
+        double const *__restrict sides,
+        double const *__restrict rhs,
+        int numPoints,
+        double omega) {
+    double maxDiff = 0.0;
+
+    if (rhs != nullptr) {
+#pragma omp simd reduction(max : maxDiff)
+        for (int k = 0; k < numPoints; ++k) {
+            double tmp = (upper[k] + lower[k] + sides[k] + sides[k + 1] + rhs[k]) / 4.0;
+            double prev = points[k];
+            double next = (1.0 - omega) * prev + omega * tmp;
+            points[k] = next;
+            maxDiff = std::max(maxDiff, fabs(prev - next));
+        }
+        return maxDiff;
+    }
+
+#pragma omp simd reduction(max : maxDiff)
+    for (int k = 0; k < numPoints; ++k) {
+        /* The same order of additions as GP(i - 1, j) + GP(i + 1, j) + GP(i, j - 1) + GP(i, j + 1). */
+        double tmp = (upper[k] + lower[k] + sides[k] + sides[k + 1]) / 4.0;
+        double prev = points[k];
+        double next = (1.0 - omega) * prev + omega * tmp;
+        points[k] = next;
+        maxDiff = std::max(maxDiff, fabs(prev - next));
+    }
+
+    return maxDiff;
+}
+
+void GridFragment::fillWithZeros() {
+    size_t numValues = (size_t) (this->lastRowIdxExcl - this->firstRowIdxIncl + 2) * this->rowStride;
+    for (int color = 0; color < 2; ++color) {
+        std::fill(this->storage[color], this->storage[color] + numValues, 0.0);
+    }
+}
+
+void GridFragment::getInteriorBounds(int *bounds) {
+    bounds[0] = std::max(this->firstRowIdxIncl, 1);
+    bounds[1] = std::min(this->lastRowIdxExcl, this->gridDimension - 1);
+    bounds[2] = std::max(this->firstColIdxIncl, 1);
+    bounds[3] = std::min(this->lastColIdxExcl, this->gridDimension - 1);
+}
+
+void GridFragment::exchangeGhosts(MPI_Comm comm) {
+    if (comm == MPI_COMM_NULL) {
+        return;
+    }
+
+    int neighbors[2][2];
+    MPI_Cart_shift(comm, 0, 1, &neighbors[0][0], &neighbors[0][1]);
+    MPI_Cart_shift(comm, 1, 1, &neighbors[1][0], &neighbors[1][1]);
+
+    int n = this->gridDimension;
+    int numRows = this->lastRowIdxExcl - this->firstRowIdxIncl;
+    int firstCol = std::max(this->firstColIdxIncl - 1, 0);
+    int lastCol = std::min(this->lastColIdxExcl + 1, n);
+    std::vector<double> sendBuffer(std::max(numRows, lastCol - firstCol));
+    std::vector<double> recvBuffer(sendBuffer.size());
+
+    /* Columns first; the rows then carry the ghost columns to the corners. */
+    for (int side = 0; side < 2; ++side) {
+        int sendColIdx = side == 0 ? this->firstColIdxIncl : this->lastColIdxExcl - 1;
+        int recvColIdx = side == 0 ? this->lastColIdxExcl : this->firstColIdxIncl - 1;
+        int source = neighbors[1][1 - side];
+
+        for (int rowIdx = this->firstRowIdxIncl; rowIdx < this->lastRowIdxExcl; ++rowIdx) {
+            sendBuffer[rowIdx - this->firstRowIdxIncl] = GP(this, rowIdx, sendColIdx);
+        }
+        MPI_Sendrecv(sendBuffer.data(), numRows, MPI_DOUBLE, neighbors[1][side], GHOST_MSG_TAG,
+                     recvBuffer.data(), numRows, MPI_DOUBLE, source, GHOST_MSG_TAG,
+                     comm, MPI_STATUS_IGNORE);
+        if (source != MPI_PROC_NULL) {
+            for (int rowIdx = this->firstRowIdxIncl; rowIdx < this->lastRowIdxExcl; ++rowIdx) {
+                GP(this, rowIdx, recvColIdx) = recvBuffer[rowIdx - this->firstRowIdxIncl];
+            }
+        }
+    }
+
+    for (int side = 0; side < 2; ++side) {
+        int sendRowIdx = side == 0 ? this->firstRowIdxIncl : this->lastRowIdxExcl - 1;
+        int recvRowIdx = side == 0 ? this->lastRowIdxExcl : this->firstRowIdxIncl - 1;
+        int source = neighbors[0][1 - side];
+
+        for (int colIdx = firstCol; colIdx < lastCol; ++colIdx) {
+            sendBuffer[colIdx - firstCol] = GP(this, sendRowIdx, colIdx);
+        }
+        MPI_Sendrecv(sendBuffer.data(), lastCol - firstCol, MPI_DOUBLE, neighbors[0][side],
+                     GHOST_MSG_TAG, recvBuffer.data(), lastCol - firstCol, MPI_DOUBLE, source,
+                     GHOST_MSG_TAG, comm, MPI_STATUS_IGNORE);
+        if (source != MPI_PROC_NULL) {
+            for (int colIdx = firstCol; colIdx < lastCol; ++colIdx) {
+                GP(this, recvRowIdx, colIdx) = recvBuffer[colIdx - firstCol];
+            }
+        }
+    }
 }
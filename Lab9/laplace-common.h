@@ -8,31 +8,100 @@
 #define __LAPLACE_COMMON_H__
 
 #include <cmath>
+#include <mpi.h>
 
 /**
  * A reference to the grid point with
  * coordinates (i, j). It is assumed that
- * row i belongs to fragment fp.
+ * point (i, j) belongs to fragment fp or
+ * to its ghost rows and columns.
  */
-#define GP(fp, i, j) ((fp)->data[((i) + (j)) % 2][(i) - (fp)->firstRowIdxIncl + 1][(j) / 2])
+#define GP(fp, i, j) ((fp)->data[((i) + (j)) % 2][(i) - (fp)->firstRowIdxIncl + 1] \
+                                [((j) - (fp)->firstColIdxIncl + 2) / 2])
 
 #define PRINT_MSG_TAG 543
+#define GHOST_MSG_TAG 545
+
+/**
+ * Alignment of the color blocks of a fragment
+ * and of each of their rows: a cache line, and
+ * a whole AVX-512 vector.
+ */
+#define GRID_ROW_ALIGNMENT 64
 
 class InputOptions {
 private:
     int numPointsPerDimension;
     bool verbose;
     int errorCode;
+    bool amortizedConvergenceCheck;
+    int multigridCycleIndex;
+    int cgPreconditioner;
+    char const *checkpointPath;
+    int checkpointInterval;
+    char const *restartPath;
+    char const *outputPath;
+    char const *textOutputPath;
 
 public:
-    InputOptions(int numPointsPerDimension, bool verbose, int errorCode) :
+    InputOptions(int numPointsPerDimension, bool verbose, int errorCode,
+                 bool amortizedConvergenceCheck = false,
+                 int multigridCycleIndex = 0,
+                 int cgPreconditioner = 0,
+                 char const *checkpointPath = nullptr,
+                 int checkpointInterval = 0,
+                 char const *restartPath = nullptr,
+                 char const *outputPath = nullptr,
+                 char const *textOutputPath = nullptr) :
             numPointsPerDimension(numPointsPerDimension),
             verbose(verbose),
-            errorCode(errorCode) {}
+            errorCode(errorCode),
+            amortizedConvergenceCheck(amortizedConvergenceCheck),
+            multigridCycleIndex(multigridCycleIndex),
+            cgPreconditioner(cgPreconditioner),
+            checkpointPath(checkpointPath),
+            checkpointInterval(checkpointInterval),
+            restartPath(restartPath),
+            outputPath(outputPath),
+            textOutputPath(textOutputPath) {}
 
     int getNumPointsPerDimension();
     bool isVerbose();
     int getErrorCode();
+
+    /**
+     * Whether the global convergence test runs
+     * only every few iterations (parallel only).
+     */
+    bool isConvergenceCheckAmortized();
+
+    /**
+     * 1 for multigrid V-cycles, 2 for W-cycles,
+     * 0 for plain SOR.
+     */
+    int getMultigridCycleIndex();
+
+    /**
+     * 1 for conjugate gradients with Jacobi,
+     * 2 with SSOR preconditioning, 0 for no CG.
+     */
+    int getCgPreconditioner();
+
+    /**
+     * The file to write checkpoints to every
+     * getCheckpointInterval() iterations, and the
+     * one to restart from; nullptr if none (parallel only).
+     */
+    char const *getCheckpointPath();
+    int getCheckpointInterval();
+    char const *getRestartPath();
+
+    /**
+     * The files to write the result to, in binary
+     * and as text; nullptr if none (parallel only).
+     */
+    char const *getOutputPath();
+    char const *getTextOutputPath();
 };
 
 class Utils {
@@ -44,22 +113,62 @@ public:
 
 /**
  * We explicitly split data for the two colors.
+ * A fragment is a block of rows and columns of
+ * the grid, surrounded by ghost rows and columns.
  * Each buffer has enough space to hold all
- * points from a row with the same color.
+ * points from a row of the block, including its
+ * ghost columns, with the same color; the owned
+ * ones start at index 1. The rows of a color are
+ * views into one aligned block (storage), rowStride
+ * doubles apart.
  */
 class GridFragment {
 public:
     double **data[2];
+    double *storage[2];
+    int rowStride;
     double *extraRowForPrinting;
     int gridDimension;
     int firstRowIdxIncl;
     int lastRowIdxExcl;
+    int firstColIdxIncl;
+    int lastColIdxExcl;
+    int numProcessRows;
+    int numProcessCols;
 
+    /**
+     * A fragment of whole rows: the grid split among
+     * numProcesses processes in a single column.
+     */
     GridFragment(int numPointsPerDimension,
                  int numProcesses,
                  int myRank,
                  bool debug = false);
 
+    /**
+     * A block of the grid split among processes
+     * arranged in a processGridDims[0] x processGridDims[1]
+     * grid, ranked row by row (as in MPI_Cart_create);
+     * myCoords are the coordinates of this process.
+     */
+    GridFragment(int numPointsPerDimension,
+                 int const *processGridDims,
+                 int const *myCoords,
+                 bool debug = false);
+
+    /**
+     * A fragment owning rows [firstRowIdxIncl, lastRowIdxExcl)
+     * and columns [firstColIdxIncl, lastColIdxExcl) of
+     * a grid, e.g. of a coarser level in multigrid.
+     * It can be printed only if it is the whole grid.
+     */
+    GridFragment(int numPointsPerDimension,
+                 int firstRowIdxIncl,
+                 int lastRowIdxExcl,
+                 int firstColIdxIncl,
+                 int lastColIdxExcl,
+                 bool debug = false);
+
     /**
      * Prints the entire grid.
      * For illustrative purposes, you may
@@ -68,16 +177,115 @@ public:
     void printEntireGrid(int myRank,
                          int numProcesses);
 
+    /**
+     * Writes the entire grid to path as N x N doubles in
+     * row order and native byte order. Every process of comm
+     * writes its own block, collectively with MPI-IO. Returns
+     * 0, or 1 if the file cannot be opened.
+     */
+    int writeEntireGrid(MPI_Comm comm,
+                        char const *path);
+
+    /**
+     * Writes the entire grid to path as text, exactly as
+     * printEntireGrid prints it. Every process of the Cartesian
+     * communicator comm formats its own block with std::to_chars
+     * and writes it at its offset, collectively with MPI-IO.
+     * Returns 0, or 1 if the file cannot be opened.
+     */
+    int writeEntireGridText(MPI_Comm comm,
+                            char const *path);
+
+    /**
+     * The owned block within the N x N grid in row
+     * order, for MPI-IO file views; to be freed by
+     * the caller.
+     */
+    MPI_Datatype createOwnedBlockFileType();
+
+    /**
+     * Copies the owned points, row by row, to block,
+     * or back from it.
+     */
+    void packOwnedPoints(double *block);
+    void unpackOwnedPoints(double const *block);
+
     /**
      * Returns the number of points of a given
-     * color in a row with a given index.
+     * color in a row with a given index that
+     * belong to the fragment.
      */
     int getNumColorPointsInRow(int rowIdx, int color);
 
+    /**
+     * Returns the number of points of a given
+     * color in a column with a given index that
+     * belong to the fragment.
+     */
+    int getNumColorPointsInCol(int colIdx, int color);
+
+    /**
+     * Relaxes the points of a color in rows
+     * [startRowIncl, endRowExcl) and columns
+     * [startColIncl, endColExcl), all owned; returns
+     * their max change. Bit-identical to relaxing
+     * point by point through GP. With rhs, a fragment
+     * of the same shape, solves 4 u(i, j) - (sum of the
+     * four neighbors) = rhs(i, j) instead of = 0.
+     */
+    double relaxBlock(int color,
+                      int startRowIncl,
+                      int endRowExcl,
+                      int startColIncl,
+                      int endColExcl,
+                      double omega,
+                      GridFragment *rhs = nullptr);
+
+    /**
+     * Stores in bounds the rows [bounds[0], bounds[1])
+     * and columns [bounds[2], bounds[3]) that are owned
+     * and not on the boundary of the grid.
+     */
+    void getInteriorBounds(int *bounds);
+
+    /**
+     * Fills the ghost rows and columns of both colors,
+     * corners included, from the neighbors in the Cartesian
+     * communicator comm; ghosts outside of the grid are left
+     * alone. Does nothing if comm is MPI_COMM_NULL.
+     */
+    void exchangeGhosts(MPI_Comm comm);
+
+    /**
+     * Sets all points, ghosts included, to 0.
+     */
+    void fillWithZeros();
+
     void initialize();
     void free();
 
 private:
+    /**
+     * The SOR update of numPoints consecutive points of
+     * a color in a row: the points of the other color
+     * above and below are at the same indices, and those
+     * to the left and right at sides[k] and sides[k + 1].
+     * rhs may be nullptr. Vectorized with OpenMP SIMD,
+     * max included.
+     */
+    static double relaxColorRow(double *__restrict points,
+                                double const *__restrict upper,
+                                double const *__restrict lower,
+                                double const *__restrict sides,
+                                double const *__restrict rhs,
+                                int numPoints,
+                                double omega);
+
+    /**
+     * Also used for columns: returns the first
+     * column owned by a process in the given
+     * column of the process grid.
+     */
     static int getFirstRowIdxOwnedByProcess(int numPointsPerDimension,
                                             int numProcesses,
                                             int rank);
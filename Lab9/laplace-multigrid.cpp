@@ -0,0 +1,413 @@
+/*
+ * Geometric multigrid for the Laplace problem
+ * on (distributed) grid fragments.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "laplace-common.h"
+#include "laplace-multigrid.h"
+
+/*
+ * A level of the hierarchy: the correction u (the solution itself on
+ * the finest level), its right-hand side f, the residual r and, if there
+ * is a coarser level, the full-weighted residual restricted from. comm is
+ * MPI_COMM_NULL if the whole level is at this process. A level gathered
+ * at rank 0 of the finer level's communicator (spreadComm) also has
+ * spreadU and spreadF at every process of it: the same values, laid out
+ * like the finer level, for the transfers. Other processes have no u.
+ */
+class MultigridLevel {
+public:
+    int numPoints;
+    MPI_Comm comm;
+    GridFragment *u;
+    GridFragment *f;
+    GridFragment *r;
+    GridFragment *weighted;
+    bool agglomerated;
+    MPI_Comm spreadComm;
+    GridFragment *spreadU;
+    GridFragment *spreadF;
+};
+
+static GridFragment *createFragment(int numPoints, int const *ranges) {
+    return new GridFragment(numPoints, ranges[0], ranges[1], ranges[2], ranges[3]);
+}
+
+/*
+ * Point idx of a grid of fromN points per dimension lies *frac of the
+ * way from point *lowIdx to point *lowIdx + 1 of a grid of toN points
+ * over the same square.
+ */
+static void locatePoint(int idx, int fromN, int toN, int *lowIdx, double *frac) {
+    long long position = (long long) idx * (toN - 1);
+    *lowIdx = (int) (position / (fromN - 1));
+    *frac = (double) (position % (fromN - 1)) / (fromN - 1);
+}
+
+/* The first coarse point at or after fine point fineIdx. */
+static int getCoarseIdx(int fineIdx, int n, int coarseN) {
+    return (int) (((long long) fineIdx * (coarseN - 1) + n - 2) / (n - 1));
+}
+
+static std::vector<MultigridLevel> createLevels(MPI_Comm gridComm, GridFragment *frag) {
+    std::vector<MultigridLevel> levels;
+    int ranges[4] = {frag->firstRowIdxIncl, frag->lastRowIdxExcl,
+                     frag->firstColIdxIncl, frag->lastColIdxExcl};
+    int n = frag->gridDimension;
+
+    levels.push_back(MultigridLevel{n, gridComm, frag, createFragment(n, ranges),
+                                    createFragment(n, ranges), nullptr, false, MPI_COMM_NULL,
+                                    nullptr, nullptr});
+
+    /*
+     * Coarse point I is at fine position I (n - 1) / (coarseN - 1): fine
+     * point 2 I for odd n, in between two fine points now and then otherwise.
+     * It belongs to the process owning the fine point at or before it.
+     */
+    while (n >= 5 && levels.back().u != nullptr) {
+        MultigridLevel &finer = levels.back();
+        int coarseN = n / 2 + 1;
+        MultigridLevel coarser{coarseN, finer.comm, nullptr, nullptr, nullptr, nullptr, false,
+                               MPI_COMM_NULL, nullptr, nullptr};
+        int wholeRanges[4] = {0, coarseN, 0, coarseN};
+
+        if (finer.comm == MPI_COMM_NULL) {
+            coarser.u = createFragment(coarseN, wholeRanges);
+            coarser.f = createFragment(coarseN, wholeRanges);
+            coarser.r = createFragment(coarseN, wholeRanges);
+        } else {
+            int coarseRanges[4] = {getCoarseIdx(finer.u->firstRowIdxIncl, n, coarseN),
+                                   getCoarseIdx(finer.u->lastRowIdxExcl, n, coarseN),
+                                   getCoarseIdx(finer.u->firstColIdxIncl, n, coarseN),
+                                   getCoarseIdx(finer.u->lastColIdxExcl, n, coarseN)};
+            int minPoints = std::min(coarseRanges[1] - coarseRanges[0],
+                                     coarseRanges[3] - coarseRanges[2]);
+            MPI_Allreduce(MPI_IN_PLACE, &minPoints, 1, MPI_INT, MPI_MIN, finer.comm);
+
+            if (minPoints >= MULTIGRID_MIN_POINTS_PER_PROCESS) {
+                coarser.u = createFragment(coarseN, coarseRanges);
+                coarser.f = createFragment(coarseN, coarseRanges);
+                coarser.r = createFragment(coarseN, coarseRanges);
+            } else {
+                int myRank;
+                MPI_Comm_rank(finer.comm, &myRank);
+                coarser.comm = MPI_COMM_NULL;
+                coarser.agglomerated = true;
+                coarser.spreadComm = finer.comm;
+                coarser.spreadU = createFragment(coarseN, coarseRanges);
+                coarser.spreadF = createFragment(coarseN, coarseRanges);
+                if (myRank == 0) {
+                    coarser.u = createFragment(coarseN, wholeRanges);
+                    coarser.f = createFragment(coarseN, wholeRanges);
+                    coarser.r = createFragment(coarseN, wholeRanges);
+                }
+            }
+        }
+
+        int fineRanges[4] = {finer.u->firstRowIdxIncl, finer.u->lastRowIdxExcl,
+                             finer.u->firstColIdxIncl, finer.u->lastColIdxExcl};
+        finer.weighted = createFragment(n, fineRanges);
+        levels.push_back(coarser);
+        n = coarseN;
+    }
+
+    return levels;
+}
+
+static void destroyLevels(std::vector<MultigridLevel> &levels) {
+    for (size_t l = 0; l < levels.size(); ++l) {
+        GridFragment *frags[6] = {l > 0 ? levels[l].u : nullptr, levels[l].f, levels[l].r,
+                                  levels[l].weighted, levels[l].spreadU, levels[l].spreadF};
+        for (auto frag : frags) {
+            if (frag != nullptr) {
+                frag->free();
+            }
+        }
+    }
+    levels.clear();
+}
+
+/* Runs red-black sweeps on u of a level; returns the local max change of the last one. */
+static double smooth(MultigridLevel &level, int numSweeps, double omega) {
+    int bounds[4];
+    double maxDiff = 0.0;
+
+    level.u->getInteriorBounds(bounds);
+    for (int sweep = 0; sweep < numSweeps; ++sweep) {
+        maxDiff = 0.0;
+        for (int color = 0; color < 2; ++color) {
+            level.u->exchangeGhosts(level.comm);
+            maxDiff = std::max(maxDiff, level.u->relaxBlock(color, bounds[0], bounds[1], bounds[2],
+                                                            bounds[3], omega, level.f));
+        }
+    }
+
+    return maxDiff;
+}
+
+/* r = f - (4 u(i, j) - the sum of its neighbors), 0 on the boundary; returns the local max |r|. */
+static double computeResidual(MultigridLevel &level) {
+    GridFragment *u = level.u;
+    double maxResidual = 0.0;
+    int bounds[4];
+
+    u->getInteriorBounds(bounds);
+    u->exchangeGhosts(level.comm);
+
+    for (int rowIdx = u->firstRowIdxIncl; rowIdx < u->lastRowIdxExcl; ++rowIdx) {
+        for (int colIdx = u->firstColIdxIncl; colIdx < u->lastColIdxExcl; ++colIdx) {
+            double residual = 0.0;
+            if (rowIdx >= bounds[0] && rowIdx < bounds[1] &&
+                colIdx >= bounds[2] && colIdx < bounds[3]) {
+                residual = GP(level.f, rowIdx, colIdx) -
+                        (4.0 * GP(u, rowIdx, colIdx) -
+                         GP(u, rowIdx - 1, colIdx) - GP(u, rowIdx + 1, colIdx) -
+                         GP(u, rowIdx, colIdx - 1) - GP(u, rowIdx, colIdx + 1));
+            }
+            GP(level.r, rowIdx, colIdx) = residual;
+            maxResidual = std::max(maxResidual, fabs(residual));
+        }
+    }
+
+    return maxResidual;
+}
+
+/* Bilinear interpolation of frag (ghosts filled) frac of the way past point (i, j). */
+static double interpolate(GridFragment *frag, int i, int j, double rowFrac, double colFrac) {
+    double value = (1.0 - rowFrac) * (1.0 - colFrac) * GP(frag, i, j);
+    if (rowFrac > 0.0) {
+        value += rowFrac * (1.0 - colFrac) * GP(frag, i + 1, j);
+    }
+    if (colFrac > 0.0) {
+        value += (1.0 - rowFrac) * colFrac * GP(frag, i, j + 1);
+    }
+    if (rowFrac > 0.0 && colFrac > 0.0) {
+        value += rowFrac * colFrac * GP(frag, i + 1, j + 1);
+    }
+    return value;
+}
+
+/* Full weighting of the residual (ghosts filled) at the owned points, ghosts filled too. */
+static void weightResidual(MultigridLevel &level) {
+    GridFragment *r = level.r;
+    int bounds[4];
+
+    r->getInteriorBounds(bounds);
+    for (int rowIdx = r->firstRowIdxIncl; rowIdx < r->lastRowIdxExcl; ++rowIdx) {
+        for (int colIdx = r->firstColIdxIncl; colIdx < r->lastColIdxExcl; ++colIdx) {
+            double value = 0.0;
+            if (rowIdx >= bounds[0] && rowIdx < bounds[1] &&
+                colIdx >= bounds[2] && colIdx < bounds[3]) {
+                int i = rowIdx;
+                int j = colIdx;
+                double center = GP(r, i, j);
+                double edges = GP(r, i - 1, j) + GP(r, i + 1, j) + GP(r, i, j - 1) + GP(r, i, j + 1);
+                double corners = GP(r, i - 1, j - 1) + GP(r, i - 1, j + 1) +
+                        GP(r, i + 1, j - 1) + GP(r, i + 1, j + 1);
+                value = (4.0 * center + 2.0 * edges + corners) / 16.0;
+            }
+            GP(level.weighted, rowIdx, colIdx) = value;
+        }
+    }
+    level.weighted->exchangeGhosts(level.comm);
+}
+
+/*
+ * The full-weighted fine residual at the coarse points into the coarse
+ * right-hand side. The coarse operator has a spacing (n - 1) / (coarseN - 1)
+ * times larger, so with the unscaled 5-point stencil its right-hand side
+ * is larger by the square of that, 4 for odd n.
+ */
+static void restrictResidual(GridFragment *weighted, GridFragment *coarseF) {
+    int n = weighted->gridDimension;
+    int coarseN = coarseF->gridDimension;
+    double ratio = (double) (n - 1) / (coarseN - 1);
+    int bounds[4];
+
+    coarseF->getInteriorBounds(bounds);
+    for (int rowIdx = coarseF->firstRowIdxIncl; rowIdx < coarseF->lastRowIdxExcl; ++rowIdx) {
+        int i;
+        double rowFrac;
+        locatePoint(rowIdx, coarseN, n, &i, &rowFrac);
+        for (int colIdx = coarseF->firstColIdxIncl; colIdx < coarseF->lastColIdxExcl; ++colIdx) {
+            int j;
+            double colFrac;
+            locatePoint(colIdx, coarseN, n, &j, &colFrac);
+            double value = 0.0;
+            if (rowIdx >= bounds[0] && rowIdx < bounds[1] &&
+                colIdx >= bounds[2] && colIdx < bounds[3]) {
+                value = ratio * ratio * interpolate(weighted, i, j, rowFrac, colFrac);
+            }
+            GP(coarseF, rowIdx, colIdx) = value;
+        }
+    }
+}
+
+/* Adds the bilinear interpolation of the coarse correction (ghosts filled) to fine u. */
+static void prolongateAndAdd(GridFragment *coarseU, GridFragment *fineU) {
+    int n = fineU->gridDimension;
+    int coarseN = coarseU->gridDimension;
+    int bounds[4];
+
+    fineU->getInteriorBounds(bounds);
+    for (int rowIdx = bounds[0]; rowIdx < bounds[1]; ++rowIdx) {
+        int i;
+        double rowFrac;
+        locatePoint(rowIdx, n, coarseN, &i, &rowFrac);
+        for (int colIdx = bounds[2]; colIdx < bounds[3]; ++colIdx) {
+            int j;
+            double colFrac;
+            locatePoint(colIdx, n, coarseN, &j, &colFrac);
+            GP(fineU, rowIdx, colIdx) += interpolate(coarseU, i, j, rowFrac, colFrac);
+        }
+    }
+}
+
+/* Moves the owned points of spread to the whole-level fragment at rank 0 of comm. */
+static void gatherAtRoot(MPI_Comm comm, GridFragment *spread, GridFragment *whole) {
+    int myRank, numProcesses;
+    MPI_Comm_rank(comm, &myRank);
+    MPI_Comm_size(comm, &numProcesses);
+
+    int ranges[4] = {spread->firstRowIdxIncl, spread->lastRowIdxExcl,
+                     spread->firstColIdxIncl, spread->lastColIdxExcl};
+    std::vector<double> block;
+    for (int rowIdx = ranges[0]; rowIdx < ranges[1]; ++rowIdx) {
+        for (int colIdx = ranges[2]; colIdx < ranges[3]; ++colIdx) {
+            block.push_back(GP(spread, rowIdx, colIdx));
+        }
+    }
+
+    std::vector<int> allRanges(myRank == 0 ? 4 * numProcesses : 0);
+    MPI_Gather(ranges, 4, MPI_INT, allRanges.data(), 4, MPI_INT, 0, comm);
+
+    std::vector<int> counts(numProcesses, 0);
+    std::vector<int> displs(numProcesses, 0);
+    if (myRank == 0) {
+        for (int p = 0; p < numProcesses; ++p) {
+            int const *r = &allRanges[4 * p];
+            counts[p] = (r[1] - r[0]) * (r[3] - r[2]);
+            displs[p] = p == 0 ? 0 : displs[p - 1] + counts[p - 1];
+        }
+    }
+
+    std::vector<double> all(myRank == 0 ? displs[numProcesses - 1] + counts[numProcesses - 1] : 0);
+    MPI_Gatherv(block.data(), (int) block.size(), MPI_DOUBLE, all.data(), counts.data(),
+                displs.data(), MPI_DOUBLE, 0, comm);
+
+    if (myRank == 0) {
+        for (int p = 0; p < numProcesses; ++p) {
+            int const *r = &allRanges[4 * p];
+            double const *values = all.data() + displs[p];
+            for (int rowIdx = r[0]; rowIdx < r[1]; ++rowIdx) {
+                for (int colIdx = r[2]; colIdx < r[3]; ++colIdx) {
+                    GP(whole, rowIdx, colIdx) = *values++;
+                }
+            }
+        }
+    }
+}
+
+/* Copies the whole-level fragment at rank 0 of comm to spread everywhere, ghosts included. */
+static void broadcastFromRoot(MPI_Comm comm, GridFragment *whole, GridFragment *spread) {
+    int myRank;
+    int n = spread->gridDimension;
+    std::vector<double> all((size_t) n * n);
+
+    MPI_Comm_rank(comm, &myRank);
+    if (myRank == 0) {
+        for (int rowIdx = 0; rowIdx < n; ++rowIdx) {
+            for (int colIdx = 0; colIdx < n; ++colIdx) {
+                all[(size_t) rowIdx * n + colIdx] = GP(whole, rowIdx, colIdx);
+            }
+        }
+    }
+    MPI_Bcast(all.data(), n * n, MPI_DOUBLE, 0, comm);
+
+    for (int rowIdx = std::max(spread->firstRowIdxIncl - 1, 0);
+         rowIdx < std::min(spread->lastRowIdxExcl + 1, n); ++rowIdx) {
+        for (int colIdx = std::max(spread->firstColIdxIncl - 1, 0);
+             colIdx < std::min(spread->lastColIdxExcl + 1, n); ++colIdx) {
+            GP(spread, rowIdx, colIdx) = all[(size_t) rowIdx * n + colIdx];
+        }
+    }
+}
+
+/* SOR on the coarsest level, see MULTIGRID_COARSEST_REDUCTION. */
+static void solveCoarsest(MultigridLevel &level) {
+    double omega = Utils::getRelaxationFactor(level.numPoints);
+    double firstMaxDiff = -1.0;
+
+    for (int sweep = 0; sweep < MULTIGRID_MAX_COARSEST_SWEEPS_PER_POINT * level.numPoints; ++sweep) {
+        double maxDiff = smooth(level, 1, omega);
+        if (level.comm != MPI_COMM_NULL) {
+            MPI_Allreduce(MPI_IN_PLACE, &maxDiff, 1, MPI_DOUBLE, MPI_MAX, level.comm);
+        }
+        if (firstMaxDiff < 0.0) {
+            firstMaxDiff = maxDiff;
+        }
+        if (maxDiff <= firstMaxDiff * MULTIGRID_COARSEST_REDUCTION) {
+            break;
+        }
+    }
+}
+
+/* One cycle from level l down: a V-cycle for cycleIndex 1, a W-cycle for 2. */
+static void performCycle(std::vector<MultigridLevel> &levels, size_t l, int cycleIndex) {
+    MultigridLevel &level = levels[l];
+
+    if (l + 1 == levels.size()) {
+        solveCoarsest(level);
+        return;
+    }
+
+    MultigridLevel &coarser = levels[l + 1];
+
+    smooth(level, MULTIGRID_NUM_PRE_SWEEPS, 1.0);
+    computeResidual(level);
+    level.r->exchangeGhosts(level.comm);
+    weightResidual(level);
+    restrictResidual(level.weighted, coarser.agglomerated ? coarser.spreadF : coarser.f);
+
+    if (coarser.agglomerated) {
+        gatherAtRoot(coarser.spreadComm, coarser.spreadF, coarser.f);
+    }
+    if (coarser.u != nullptr) {
+        coarser.u->fillWithZeros();
+        for (int visit = 0; visit < cycleIndex; ++visit) {
+            performCycle(levels, l + 1, cycleIndex);
+        }
+        coarser.u->exchangeGhosts(coarser.comm);
+    }
+    if (coarser.agglomerated) {
+        broadcastFromRoot(coarser.spreadComm, coarser.u, coarser.spreadU);
+    }
+
+    prolongateAndAdd(coarser.agglomerated ? coarser.spreadU : coarser.u, level.u);
+    smooth(level, MULTIGRID_NUM_POST_SWEEPS, 1.0);
+}
+
+std::tuple<int, double> runMultigrid(MPI_Comm gridComm, GridFragment *frag, int cycleIndex,
+                                     double epsilon) {
+    auto levels = createLevels(gridComm, frag);
+    double maxDiff = 0.0;
+    int numCycles = 0;
+
+    do {
+        performCycle(levels, 0, cycleIndex);
+        ++numCycles;
+
+        /* What a Gauss-Seidel update would change, comparable to the SOR criterion. */
+        maxDiff = computeResidual(levels[0]) / 4.0;
+        if (gridComm != MPI_COMM_NULL) {
+            MPI_Allreduce(MPI_IN_PLACE, &maxDiff, 1, MPI_DOUBLE, MPI_MAX, gridComm);
+        }
+    } while (maxDiff > epsilon);
+
+    destroyLevels(levels);
+
+    return std::make_tuple(numCycles, maxDiff);
+}
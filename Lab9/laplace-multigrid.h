@@ -0,0 +1,59 @@
+/*
+ * Geometric multigrid for the Laplace problem
+ * on (distributed) grid fragments.
+ */
+
+#ifndef __LAPLACE_MULTIGRID_H__
+#define __LAPLACE_MULTIGRID_H__
+
+#include <mpi.h>
+#include <tuple>
+#include "laplace-common.h"
+
+#define MULTIGRID_V_CYCLE 1
+#define MULTIGRID_W_CYCLE 2
+
+/**
+ * Red-black Gauss-Seidel sweeps before
+ * and after the coarse-grid correction.
+ */
+#define MULTIGRID_NUM_PRE_SWEEPS 2
+#define MULTIGRID_NUM_POST_SWEEPS 2
+
+/**
+ * A coarser level stays distributed only if every process
+ * owns at least this many of its rows and columns; otherwise
+ * it and all coarser ones are gathered at a single process.
+ */
+#define MULTIGRID_MIN_POINTS_PER_PROCESS 8
+
+/**
+ * The coarsest level is solved by SOR until the change
+ * of a sweep drops by this factor, or for at most
+ * MULTIGRID_MAX_COARSEST_SWEEPS_PER_POINT * N sweeps.
+ */
+#define MULTIGRID_COARSEST_REDUCTION 1e-3
+#define MULTIGRID_MAX_COARSEST_SWEEPS_PER_POINT 10
+
+/**
+ * Solves the Laplace problem on frag, whose boundary points
+ * hold the boundary values, by multigrid cycles: cycleIndex is
+ * MULTIGRID_V_CYCLE or MULTIGRID_W_CYCLE. A grid of N points is
+ * coarsened to N / 2 + 1 points down to 3 or 4, whatever N: for odd
+ * N the coarse points are every other fine point, otherwise they are
+ * spread evenly and some fall between two fine points. Smoothing is
+ * red-black Gauss-Seidel, restriction full weighting (interpolated
+ * bilinearly at such coarse points) and prolongation bilinear.
+ * Cycles stop once the largest change a
+ * Gauss-Seidel update would make, max |residual| / 4, is at most
+ * epsilon. gridComm is the Cartesian communicator of the processes
+ * sharing the grid, or MPI_COMM_NULL if frag is the whole grid
+ * (and MPI is not used at all). Returns the number of cycles and
+ * that change.
+ */
+std::tuple<int, double> runMultigrid(MPI_Comm gridComm,
+                                     GridFragment *frag,
+                                     int cycleIndex,
+                                     double epsilon);
+
+#endif /* __LAPLACE_MULTIGRID_H__ */
@@ -4,26 +4,69 @@
  * Refactoring 2019, Łukasz Rączkowski
  */
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <cstring>
+#include <tuple>
+#include <vector>
 #include <sys/time.h>
 #include <mpi.h>
 #include "laplace-common.h"
+#include "laplace-multigrid.h"
+#include "laplace-cg.h"
+#include "laplace-checkpoint.h"
 
 #define OPTION_VERBOSE "--verbose"
+#define OPTION_AMORTIZED_CHECK "--amortized-check"
+#define OPTION_V_CYCLE "--v-cycle"
+#define OPTION_W_CYCLE "--w-cycle"
+#define OPTION_CG "--cg"
+#define OPTION_CG_SSOR "--cg-ssor"
+#define OPTION_CHECKPOINT "--checkpoint"
+#define OPTION_CHECKPOINT_INTERVAL "--checkpoint-interval"
+#define OPTION_RESTART "--restart"
+#define OPTION_OUTPUT "--output"
+#define OPTION_OUTPUT_TEXT "--output-text"
+#define HALO_MSG_TAG 544
+
+/* Iterations between global convergence tests in the amortized mode. */
+#define CHECK_INTERVAL_INITIAL 4
+#define CHECK_INTERVAL_MAX 64
 
 static void printUsage(char const* progName) {
     std::cerr << "Usage:" << std::endl <<
-              "    " << progName << " [--verbose] <N>" << std::endl <<
+              "    " << progName << " [--verbose] [--amortized-check | --v-cycle | --w-cycle | --cg | --cg-ssor]" << std::endl <<
+              "        [--checkpoint <file> [--checkpoint-interval <iters>]] [--restart <file>]" << std::endl <<
+              "        [--output <file>] [--output-text <file>] <N>" << std::endl <<
               "Where:" << std::endl <<
               "   <N>         The number of points in each dimension (at least 4)." << std::endl <<
-              "   " << OPTION_VERBOSE << "   Prints the input and output systems." << std::endl;
+              "   " << OPTION_VERBOSE << "   Prints the input and output systems." << std::endl <<
+              "   " << OPTION_AMORTIZED_CHECK << "   Tests convergence every few iterations," << std::endl <<
+              "                       which may then run a few iterations past it." << std::endl <<
+              "   " << OPTION_V_CYCLE << ", " << OPTION_W_CYCLE << "   Solves with multigrid cycles instead of SOR;" << std::endl <<
+              "                       best for N = m * 2^k + 1 with a small m." << std::endl <<
+              "   " << OPTION_CG << ", " << OPTION_CG_SSOR << "   Solves with conjugate gradients instead of SOR," << std::endl <<
+              "                       with Jacobi or red-black SSOR preconditioning." << std::endl <<
+              "   " << OPTION_CHECKPOINT << " <file>   Saves the grid of SOR every <iters> iterations" << std::endl <<
+              "                       (default " << CHECKPOINT_INTERVAL_DEFAULT << ") to <file>, in the background." << std::endl <<
+              "   " << OPTION_RESTART << " <file>   Starts SOR from the last checkpoint in <file>," << std::endl <<
+              "                       saved by any number of processes." << std::endl <<
+              "   " << OPTION_OUTPUT << " <file>   Writes the result as N x N doubles in row order." << std::endl <<
+              "   " << OPTION_OUTPUT_TEXT << " <file>   Writes the result as text, as " << OPTION_VERBOSE << " prints it." << std::endl;
 }
 
-static InputOptions parseInput(int argc, char * argv[], int numProcesses) {
+static InputOptions parseInput(int argc, char * argv[], int const *processGridDims) {
     int numPointsPerDimension = 0;
     bool verbose = false;
+    bool amortizedCheck = false;
+    int multigridCycleIndex = 0;
+    int cgPreconditioner = 0;
+    char const *checkpointPath = nullptr;
+    int checkpointInterval = CHECKPOINT_INTERVAL_DEFAULT;
+    char const *restartPath = nullptr;
+    char const *outputPath = nullptr;
+    char const *textOutputPath = nullptr;
     int errorCode = 0;
 
     if (argc < 2) {
@@ -31,7 +74,7 @@ static InputOptions parseInput(int argc, char * argv[], int numProcesses) {
         printUsage(argv[0]);
         errorCode = 1;
         MPI_Finalize();
-    } else if (argc > 3) {
+    } else if (argc > 15) {
         std::cerr << "ERROR: Too many arguments!" << std::endl;
         printUsage(argv[0]);
         errorCode = 2;
@@ -39,24 +82,61 @@ static InputOptions parseInput(int argc, char * argv[], int numProcesses) {
     } else {
         int argIdx = 1;
 
-        if (argc == 3) {
-            if (strncmp(argv[argIdx], OPTION_VERBOSE, strlen(OPTION_VERBOSE)) != 0) {
+        for (; argIdx < argc - 1 && errorCode == 0; ++argIdx) {
+            if (strcmp(argv[argIdx], OPTION_VERBOSE) == 0) {
+                verbose = true;
+            } else if (strcmp(argv[argIdx], OPTION_AMORTIZED_CHECK) == 0) {
+                amortizedCheck = true;
+            } else if (strcmp(argv[argIdx], OPTION_V_CYCLE) == 0) {
+                multigridCycleIndex = MULTIGRID_V_CYCLE;
+            } else if (strcmp(argv[argIdx], OPTION_W_CYCLE) == 0) {
+                multigridCycleIndex = MULTIGRID_W_CYCLE;
+            } else if (strcmp(argv[argIdx], OPTION_CG) == 0) {
+                cgPreconditioner = CG_JACOBI;
+            } else if (strcmp(argv[argIdx], OPTION_CG_SSOR) == 0) {
+                cgPreconditioner = CG_SSOR;
+            } else if (strcmp(argv[argIdx], OPTION_CHECKPOINT) == 0 && argIdx + 2 < argc) {
+                checkpointPath = argv[++argIdx];
+            } else if (strcmp(argv[argIdx], OPTION_CHECKPOINT_INTERVAL) == 0 && argIdx + 2 < argc) {
+                checkpointInterval = std::strtol(argv[++argIdx], nullptr, 10);
+            } else if (strcmp(argv[argIdx], OPTION_RESTART) == 0 && argIdx + 2 < argc) {
+                restartPath = argv[++argIdx];
+            } else if (strcmp(argv[argIdx], OPTION_OUTPUT) == 0 && argIdx + 2 < argc) {
+                outputPath = argv[++argIdx];
+            } else if (strcmp(argv[argIdx], OPTION_OUTPUT_TEXT) == 0 && argIdx + 2 < argc) {
+                textOutputPath = argv[++argIdx];
+            } else {
                 std::cerr << "ERROR: Unexpected option '" << argv[argIdx] << "'!" << std::endl;
                 printUsage(argv[0]);
                 errorCode = 3;
                 MPI_Finalize();
             }
-            verbose = true;
-            ++argIdx;
+        }
+
+        if (errorCode == 0 && (checkpointPath != nullptr || restartPath != nullptr) &&
+            (multigridCycleIndex != 0 || cgPreconditioner != 0 || checkpointInterval <= 0)) {
+            std::cerr << "ERROR: Checkpoints are supported for SOR only, "
+                      << "at a positive interval!" << std::endl;
+            printUsage(argv[0]);
+            errorCode = 3;
+            MPI_Finalize();
+        }
+
+        if (errorCode != 0) {
+            return {numPointsPerDimension, verbose, errorCode};
         }
 
         numPointsPerDimension = std::strtol(argv[argIdx], nullptr, 10);
 
-        if ((numPointsPerDimension < 4) || (numProcesses > numPointsPerDimension / 2)) {
+        if ((numPointsPerDimension < 4) ||
+            (processGridDims[0] > numPointsPerDimension / 2) ||
+            (processGridDims[1] > numPointsPerDimension / 2)) {
             /* If we had a smaller grid, we could use the sequential version. */
             std::cerr << "ERROR: The number of points, '"
                 << argv[argIdx]
-                << "', should be an iteger greater than or equal to 4; and at least 2 points per process!"
+                << "', should be an iteger greater than or equal to 4; and at least 2 rows and "
+                << "2 columns per process in a " << processGridDims[0] << " x "
+                << processGridDims[1] << " process grid!"
                 << std::endl;
             printUsage(argv[0]);
             MPI_Finalize();
@@ -64,50 +144,286 @@ static InputOptions parseInput(int argc, char * argv[], int numProcesses) {
         }
     }
 
-    return {numPointsPerDimension, verbose, errorCode};
+    return {numPointsPerDimension, verbose, errorCode, amortizedCheck, multigridCycleIndex, cgPreconditioner,
+            checkpointPath, checkpointInterval, restartPath, outputPath, textOutputPath};
+}
+
+/*
+ * Neighbors of a process in the process grid (MPI_PROC_NULL outside of
+ * it) and one exchange of halos of a color: the owned boundary rows and
+ * columns of that color go to the neighbors, and theirs to the ghost rows
+ * and columns. A sweep of one color reads only points of the other one,
+ * so the exchange can run during the sweep that needs it. Columns hold
+ * every other point of a color and are packed into contiguous buffers.
+ */
+class HaloExchange {
+public:
+    MPI_Comm gridComm;
+    int upper, lower, left, right;
+    int color;
+    MPI_Request requests[8];
+    std::vector<double> sendCols[2];
+    std::vector<double> recvCols[2];
+
+    HaloExchange(MPI_Comm gridComm, GridFragment *frag);
+
+    void start(GridFragment *frag, int color);
+
+    /**
+     * Waits for the exchange and unpacks
+     * the received ghost columns.
+     */
+    void finish(GridFragment *frag);
+};
+
+HaloExchange::HaloExchange(MPI_Comm gridComm, GridFragment *frag) : gridComm(gridComm), color(0) {
+    MPI_Cart_shift(gridComm, 0, 1, &this->upper, &this->lower);
+    MPI_Cart_shift(gridComm, 1, 1, &this->left, &this->right);
+
+    int maxPointsPerColorPerCol = (frag->lastRowIdxExcl - frag->firstRowIdxIncl + 1) / 2;
+    for (int side = 0; side < 2; ++side) {
+        this->sendCols[side].resize(maxPointsPerColorPerCol);
+        this->recvCols[side].resize(maxPointsPerColorPerCol);
+    }
+    for (int r = 0; r < 8; ++r) {
+        this->requests[r] = MPI_REQUEST_NULL;
+    }
+}
+
+void HaloExchange::start(GridFragment *frag, int color) {
+    int numOwnedRows = frag->lastRowIdxExcl - frag->firstRowIdxIncl;
+    int firstCol = frag->firstColIdxIncl;
+    int lastCol = frag->lastColIdxExcl - 1;
+    int numSent[2] = {0, 0};
+
+    this->color = color;
+
+    for (int rowIdx = frag->firstRowIdxIncl; rowIdx < frag->lastRowIdxExcl; ++rowIdx) {
+        if ((rowIdx + firstCol) % 2 == color) {
+            this->sendCols[0][numSent[0]++] = GP(frag, rowIdx, firstCol);
+        }
+        if ((rowIdx + lastCol) % 2 == color) {
+            this->sendCols[1][numSent[1]++] = GP(frag, rowIdx, lastCol);
+        }
+    }
+
+    MPI_Irecv(frag->data[color][0] + 1,
+              frag->getNumColorPointsInRow(frag->firstRowIdxIncl - 1, color),
+              MPI_DOUBLE, this->upper, HALO_MSG_TAG, this->gridComm, &this->requests[0]);
+    MPI_Irecv(frag->data[color][numOwnedRows + 1] + 1,
+              frag->getNumColorPointsInRow(frag->lastRowIdxExcl, color),
+              MPI_DOUBLE, this->lower, HALO_MSG_TAG, this->gridComm, &this->requests[1]);
+    MPI_Irecv(this->recvCols[0].data(),
+              frag->getNumColorPointsInCol(firstCol - 1, color),
+              MPI_DOUBLE, this->left, HALO_MSG_TAG, this->gridComm, &this->requests[2]);
+    MPI_Irecv(this->recvCols[1].data(),
+              frag->getNumColorPointsInCol(lastCol + 1, color),
+              MPI_DOUBLE, this->right, HALO_MSG_TAG, this->gridComm, &this->requests[3]);
+    MPI_Isend(frag->data[color][1] + 1,
+              frag->getNumColorPointsInRow(frag->firstRowIdxIncl, color),
+              MPI_DOUBLE, this->upper, HALO_MSG_TAG, this->gridComm, &this->requests[4]);
+    MPI_Isend(frag->data[color][numOwnedRows] + 1,
+              frag->getNumColorPointsInRow(frag->lastRowIdxExcl - 1, color),
+              MPI_DOUBLE, this->lower, HALO_MSG_TAG, this->gridComm, &this->requests[5]);
+    MPI_Isend(this->sendCols[0].data(), numSent[0],
+              MPI_DOUBLE, this->left, HALO_MSG_TAG, this->gridComm, &this->requests[6]);
+    MPI_Isend(this->sendCols[1].data(), numSent[1],
+              MPI_DOUBLE, this->right, HALO_MSG_TAG, this->gridComm, &this->requests[7]);
+}
+
+void HaloExchange::finish(GridFragment *frag) {
+    int ghostCols[2] = {frag->firstColIdxIncl - 1, frag->lastColIdxExcl};
+    int neighbors[2] = {this->left, this->right};
+
+    MPI_Waitall(8, this->requests, MPI_STATUSES_IGNORE);
+
+    for (int side = 0; side < 2; ++side) {
+        if (neighbors[side] == MPI_PROC_NULL) {
+            continue;
+        }
+        int numReceived = 0;
+        for (int rowIdx = frag->firstRowIdxIncl; rowIdx < frag->lastRowIdxExcl; ++rowIdx) {
+            if ((rowIdx + ghostCols[side]) % 2 == this->color) {
+                GP(frag, rowIdx, ghostCols[side]) = this->recvCols[side][numReceived++];
+            }
+        }
+    }
+}
+
+/*
+ * One red-black iteration over the fragment; returns the local max change.
+ * On entry, the exchange of color 1 halos must be in flight in halo;
+ * on exit, the one for the next iteration is.
+ */
+static double performIteration(GridFragment *frag, double omega, HaloExchange *halo) {
+    /* The outermost rows and columns of the grid are fixed. */
+    int startRowIncl = std::max(frag->firstRowIdxIncl, 1);
+    int endRowExcl = std::min(frag->lastRowIdxExcl, frag->gridDimension - 1);
+    int startColIncl = std::max(frag->firstColIdxIncl, 1);
+    int endColExcl = std::min(frag->lastColIdxExcl, frag->gridDimension - 1);
+
+    /* Points that do not touch the ghosts; at least 2 rows and columns are owned. */
+    int interiorStartRowIncl = std::max(startRowIncl, frag->firstRowIdxIncl + 1);
+    int interiorEndRowExcl = std::min(endRowExcl, frag->lastRowIdxExcl - 1);
+    int interiorStartColIncl = std::max(startColIncl, frag->firstColIdxIncl + 1);
+    int interiorEndColExcl = std::min(endColExcl, frag->lastColIdxExcl - 1);
+
+    double localMaxDiff = 0.0;
+
+    for (int color = 0; color < 2; ++color) {
+        /* The halo of the other color is in flight: interior points first. */
+        localMaxDiff = std::max(localMaxDiff,
+                                frag->relaxBlock(color, interiorStartRowIncl, interiorEndRowExcl,
+                                                 interiorStartColIncl, interiorEndColExcl, omega));
+        halo->finish(frag);
+
+        if (frag->firstRowIdxIncl >= startRowIncl) {
+            localMaxDiff = std::max(localMaxDiff,
+                                    frag->relaxBlock(color, frag->firstRowIdxIncl,
+                                                     frag->firstRowIdxIncl + 1, startColIncl,
+                                                     endColExcl, omega));
+        }
+        if (frag->lastRowIdxExcl - 1 < endRowExcl) {
+            localMaxDiff = std::max(localMaxDiff,
+                                    frag->relaxBlock(color, frag->lastRowIdxExcl - 1,
+                                                     frag->lastRowIdxExcl, startColIncl,
+                                                     endColExcl, omega));
+        }
+        if (frag->firstColIdxIncl >= startColIncl) {
+            localMaxDiff = std::max(localMaxDiff,
+                                    frag->relaxBlock(color, interiorStartRowIncl,
+                                                     interiorEndRowExcl, frag->firstColIdxIncl,
+                                                     frag->firstColIdxIncl + 1, omega));
+        }
+        if (frag->lastColIdxExcl - 1 < endColExcl) {
+            localMaxDiff = std::max(localMaxDiff,
+                                    frag->relaxBlock(color, interiorStartRowIncl,
+                                                     interiorEndRowExcl, frag->lastColIdxExcl - 1,
+                                                     frag->lastColIdxExcl, omega));
+        }
+
+        /* This color is final for the iteration: the next sweep reads it. */
+        halo->start(frag, color);
+    }
+
+    return localMaxDiff;
 }
 
+/*
+ * The number of iterations until the next convergence test. The
+ * change shrinks roughly geometrically, so the rate between the last
+ * two tests predicts when it drops to epsilon; testing halfway there
+ * keeps the overshoot small. Until it shrinks, the interval doubles.
+ */
+static int getNextCheckInterval(int checkInterval, double prevMaxDiff, double maxDiff,
+                                int numItersBetween, double epsilon) {
+    if (prevMaxDiff <= 0.0 || maxDiff <= 0.0 || maxDiff >= prevMaxDiff) {
+        return std::min(2 * checkInterval, CHECK_INTERVAL_MAX);
+    }
+
+    double logRatePerIter = log(maxDiff / prevMaxDiff) / numItersBetween;
+    double numItersLeft = log(epsilon / maxDiff) / logRatePerIter;
+
+    return std::max(1, std::min((int) (numItersLeft / 2.0), CHECK_INTERVAL_MAX));
+}
+
+/*
+ * Tests convergence only every few iterations, see getNextCheckInterval.
+ * The max change of a tested iteration is reduced while the next one
+ * runs, and the test completes right after it on every process, so all
+ * stop after the same iteration, one past the first tested iteration
+ * whose change is at most epsilon. That change is returned.
+ */
+static std::tuple<int, double> performAlgorithmAmortized(
+  MPI_Comm gridComm, GridFragment *frag, double omega, double epsilon,
+  int numIterationsDone, Checkpoint *checkpoint) {
+
+    double localMaxDiff = 0.0;
+    double maxDiff = 0.0;
+    double prevMaxDiff = 0.0;
+    int prevCheckIter = 0;
+    int checkInterval = CHECK_INTERVAL_INITIAL;
+    int nextCheckIter = checkInterval;
+    int pendingCheckIter = 0;
+    bool converged = false;
+    int numIterations = 0;
+    HaloExchange halo(gridComm, frag);
+    MPI_Request reduceRequest = MPI_REQUEST_NULL;
+
+    halo.start(frag, 1);
+
+    while (!converged) {
+        double iterMaxDiff = performIteration(frag, omega, &halo);
+        ++numIterations;
+
+        if (pendingCheckIter != 0) {
+            MPI_Wait(&reduceRequest, MPI_STATUS_IGNORE);
+            converged = maxDiff <= epsilon;
+
+            if (prevCheckIter != 0) {
+                checkInterval = getNextCheckInterval(checkInterval, prevMaxDiff, maxDiff,
+                                                     pendingCheckIter - prevCheckIter, epsilon);
+            }
+            prevMaxDiff = maxDiff;
+            prevCheckIter = pendingCheckIter;
+            nextCheckIter = std::max(pendingCheckIter + checkInterval, numIterations);
+            pendingCheckIter = 0;
+        }
+
+        /* No reduction is in flight: maxDiff is that of the last test. */
+        if (checkpoint != nullptr) {
+            checkpoint->saveIfDue(frag, numIterationsDone + numIterations, maxDiff);
+        }
+
+        if (!converged && numIterations == nextCheckIter) {
+            localMaxDiff = iterMaxDiff;
+            MPI_Iallreduce(&localMaxDiff, &maxDiff, 1, MPI_DOUBLE, MPI_MAX, gridComm,
+                           &reduceRequest);
+            pendingCheckIter = numIterations;
+        }
+    }
+
+    halo.finish(frag);
+
+    return std::make_tuple(numIterationsDone + numIterations, maxDiff);
+}
+
+/*
+ * numIterationsDone iterations were run before, e.g. by the run
+ * a checkpoint was restarted from; checkpoint may be nullptr.
+ */
 static std::tuple<int, double> performAlgorithm(
-  int myRank, int numProcesses, GridFragment *frag, double omega, double epsilon) {
-    
-    int startRowIncl = frag->firstRowIdxIncl + (myRank == 0 ? 1 : 0);
-    int endRowExcl = frag->lastRowIdxExcl - (myRank == numProcesses - 1 ? 1 : 0);
+  MPI_Comm gridComm, GridFragment *frag, double omega, double epsilon,
+  int numIterationsDone, Checkpoint *checkpoint) {
 
+    double localMaxDiff = 0.0;
     double maxDiff = 0;
     int numIterations = 0;
+    HaloExchange halo(gridComm, frag);
+
+    /* The first sweep (color 0) reads color 1 from the neighbors. */
+    halo.start(frag, 1);
 
-    /* TODO: change the following code fragment */
-    /* Implement asynchronous communication of neighboring elements */
-    /* and computation of the grid */
-    /* the following code just recomputes the appropriate grid fragment */
-    /* but does not communicate the partial results */
     do {
-        maxDiff = 0.0;
-        for (int color = 0; color < 2; ++color) {
-            for (int rowIdx = startRowIncl; rowIdx < endRowExcl; ++rowIdx) {
-                for (int colIdx = 1 + (rowIdx % 2 == color ? 1 : 0); 
-                     colIdx < frag->gridDimension - 1; 
-                     colIdx += 2) {
-                    double tmp =
-                            (GP(frag, rowIdx - 1, colIdx) +
-                             GP(frag, rowIdx + 1, colIdx) +
-                             GP(frag, rowIdx, colIdx - 1) +
-                             GP(frag, rowIdx, colIdx + 1)
-                            ) / 4.0;
-                    double diff = GP(frag, rowIdx, colIdx);
-                    GP(frag, rowIdx, colIdx) = (1.0 - omega) * diff + omega * tmp;
-                    diff = fabs(diff - GP(frag, rowIdx, colIdx));
-
-                    if (diff > maxDiff) {
-                        maxDiff = diff;
-                    }
-                }
-            }
-        }
+        localMaxDiff = performIteration(frag, omega, &halo);
+
+        /*
+         * Every iteration is tested, so no computation overlaps the
+         * reduction; only the halos of the next iteration are in flight.
+         * OPTION_AMORTIZED_CHECK reduces while the next iteration runs.
+         */
+        MPI_Allreduce(&localMaxDiff, &maxDiff, 1, MPI_DOUBLE, MPI_MAX, gridComm);
         ++numIterations;
+
+        if (checkpoint != nullptr) {
+            checkpoint->saveIfDue(frag, numIterationsDone + numIterations, maxDiff);
+        }
     } while (maxDiff > epsilon);
-    /* no code changes beyond this point should be needed */
-    return std::make_tuple(numIterations, maxDiff);
+
+    /* The exchange started for an iteration that does not run. */
+    halo.finish(frag);
+
+    return std::make_tuple(numIterationsDone + numIterations, maxDiff);
 }
 
 int main(int argc, char *argv[]) {
@@ -120,7 +436,14 @@ int main(int argc, char *argv[]) {
     MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
     MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
 
-    auto inputOptions = parseInput(argc, argv, numProcesses);
+    /* As square blocks as possible: halos of O(N / sqrt(p)) points per process. */
+    int processGridDims[2] = {0, 0};
+    int periods[2] = {0, 0};
+    int myCoords[2];
+    MPI_Comm gridComm;
+    MPI_Dims_create(numProcesses, 2, processGridDims);
+
+    auto inputOptions = parseInput(argc, argv, processGridDims);
     if (inputOptions.getErrorCode() != 0) {
         return inputOptions.getErrorCode();
     }
@@ -131,9 +454,51 @@ int main(int argc, char *argv[]) {
     double omega = Utils::getRelaxationFactor(numPointsPerDimension);
     double epsilon = Utils::getToleranceValue(numPointsPerDimension);
 
-    auto gridFragment = new GridFragment(numPointsPerDimension, numProcesses, myRank);
+    /* No reordering: ranks in gridComm are those in MPI_COMM_WORLD, as printing expects. */
+    MPI_Cart_create(MPI_COMM_WORLD, 2, processGridDims, periods, 0, &gridComm);
+    MPI_Cart_coords(gridComm, myRank, 2, myCoords);
+
+    auto gridFragment = new GridFragment(numPointsPerDimension, processGridDims, myCoords);
     gridFragment->initialize();
 
+    int numIterationsDone = 0;
+    if (inputOptions.getRestartPath() != nullptr) {
+        double restoredMaxDiff = 0.0;
+        int restoreError = Checkpoint::restore(gridComm, gridFragment, inputOptions.getRestartPath(),
+                                               &numIterationsDone, &restoredMaxDiff);
+        if (restoreError != 0) {
+            if (myRank == 0) {
+                std::cerr << "ERROR: No checkpoint of a grid of " << numPointsPerDimension
+                          << " points could be read from '" << inputOptions.getRestartPath()
+                          << "'!" << std::endl;
+            }
+            gridFragment->free();
+            MPI_Comm_free(&gridComm);
+            MPI_Finalize();
+            return 8;
+        }
+        if (myRank == 0) {
+            std::cerr << "Restarting after iteration " << numIterationsDone
+                      << " (diff=" << restoredMaxDiff << ")." << std::endl;
+        }
+    }
+
+    Checkpoint *checkpoint = nullptr;
+    if (inputOptions.getCheckpointPath() != nullptr) {
+        checkpoint = Checkpoint::create(gridComm, gridFragment, inputOptions.getCheckpointPath(),
+                                        inputOptions.getCheckpointInterval());
+        if (checkpoint == nullptr) {
+            if (myRank == 0) {
+                std::cerr << "ERROR: Cannot open '" << inputOptions.getCheckpointPath()
+                          << "' for checkpoints!" << std::endl;
+            }
+            gridFragment->free();
+            MPI_Comm_free(&gridComm);
+            MPI_Finalize();
+            return 9;
+        }
+    }
+
     if (gettimeofday(&startTime, nullptr)) {
         gridFragment->free();
         std::cerr << "ERROR: Gettimeofday failed!" << std::endl;
@@ -142,7 +507,21 @@ int main(int argc, char *argv[]) {
     }
 
     /* Start of computations. */
-    auto result = performAlgorithm(myRank, numProcesses, gridFragment, omega, epsilon);
+    std::tuple<int, double> result;
+    if (inputOptions.getMultigridCycleIndex() != 0) {
+        result = runMultigrid(gridComm, gridFragment, inputOptions.getMultigridCycleIndex(), epsilon);
+    } else if (inputOptions.getCgPreconditioner() != 0) {
+        result = runConjugateGradient(gridComm, gridFragment, inputOptions.getCgPreconditioner(), epsilon);
+    } else if (inputOptions.isConvergenceCheckAmortized()) {
+        result = performAlgorithmAmortized(gridComm, gridFragment, omega, epsilon,
+                                           numIterationsDone, checkpoint);
+    } else {
+        result = performAlgorithm(gridComm, gridFragment, omega, epsilon,
+                                  numIterationsDone, checkpoint);
+    }
+    if (checkpoint != nullptr) {
+        checkpoint->close();
+    }
     /* End of computations. */
 
     if (gettimeofday(&endTime, nullptr)) {
@@ -167,7 +546,28 @@ int main(int argc, char *argv[]) {
     if (isVerbose) {
         gridFragment->printEntireGrid(myRank, numProcesses);
     }
+
+    char const *outputPaths[2] = {inputOptions.getOutputPath(), inputOptions.getTextOutputPath()};
+    for (int text = 0; text < 2; ++text) {
+        if (outputPaths[text] == nullptr) {
+            continue;
+        }
+        double outputStartTime = MPI_Wtime();
+        int outputError = text
+                ? gridFragment->writeEntireGridText(gridComm, outputPaths[text])
+                : gridFragment->writeEntireGrid(gridComm, outputPaths[text]);
+        if (myRank == 0) {
+            if (outputError != 0) {
+                std::cerr << "ERROR: Cannot write the result to '" << outputPaths[text] << "'!"
+                          << std::endl;
+            } else {
+                std::cerr << "Output: " << outputPaths[text] << " duration(s)="
+                          << MPI_Wtime() - outputStartTime << std::endl;
+            }
+        }
+    }
     gridFragment->free();
+    MPI_Comm_free(&gridComm);
     MPI_Finalize();
     return 0;
 }
@@ -9,18 +9,29 @@
 #include <cstring>
 #include <sys/time.h>
 #include <iomanip>
+#include <tuple>
 #include <vector>
 #include "laplace-common.h"
+#include "laplace-multigrid.h"
+#include "laplace-cg.h"
 
 #define OPTION_VERBOSE "--verbose"
+#define OPTION_V_CYCLE "--v-cycle"
+#define OPTION_W_CYCLE "--w-cycle"
+#define OPTION_CG "--cg"
+#define OPTION_CG_SSOR "--cg-ssor"
 
 
 static void printUsage(char const* progName) {
     std::cerr << "Usage:" << std::endl <<
-                    "    " << progName << " [--verbose] <N>" << std::endl <<
+                    "    " << progName << " [--verbose] [--v-cycle | --w-cycle | --cg | --cg-ssor] <N>" << std::endl <<
                     "Where:" << std::endl <<
                     "   <N>         The number of points in each dimension (at least 2)." << std::endl <<
-                    "   " << OPTION_VERBOSE << "   Prints the input and output systems." << std::endl;
+                    "   " << OPTION_VERBOSE << "   Prints the input and output systems." << std::endl <<
+                    "   " << OPTION_V_CYCLE << ", " << OPTION_W_CYCLE << "   Solves with multigrid cycles instead of SOR;" << std::endl <<
+                    "                       best for N = m * 2^k + 1 with a small m." << std::endl <<
+                    "   " << OPTION_CG << ", " << OPTION_CG_SSOR << "   Solves with conjugate gradients instead of SOR," << std::endl <<
+                    "                       with Jacobi or red-black SSOR preconditioning." << std::endl;
 }
 
 static void freePointRow(const double* currentPointRow) {
@@ -85,28 +96,41 @@ static void printPoints(double **points, int numPointsPerDimension) {
 static InputOptions parseInput(int argc, char * argv[]) {
     int numPointsPerDimension = 0;
     bool verbose = false;
+    int multigridCycleIndex = 0;
+    int cgPreconditioner = 0;
     int errorCode = 0;
 
     if (argc < 2) {
         std::cerr << "ERROR: Too few arguments!" << std::endl;
         printUsage(argv[0]);
         errorCode = 1;
-    } else if (argc > 3) {
+    } else if (argc > 4) {
         std::cerr << "ERROR: Too many arguments!" << std::endl;
         printUsage(argv[0]);
         errorCode = 2;
     } else {
         int argIdx = 1;
 
-        if (argc == 3) {
-            if (strncmp(argv[argIdx], OPTION_VERBOSE, strlen(OPTION_VERBOSE)) != 0) {
+        for (; argIdx < argc - 1 && errorCode == 0; ++argIdx) {
+            if (strcmp(argv[argIdx], OPTION_VERBOSE) == 0) {
+                verbose = true;
+            } else if (strcmp(argv[argIdx], OPTION_V_CYCLE) == 0) {
+                multigridCycleIndex = MULTIGRID_V_CYCLE;
+            } else if (strcmp(argv[argIdx], OPTION_W_CYCLE) == 0) {
+                multigridCycleIndex = MULTIGRID_W_CYCLE;
+            } else if (strcmp(argv[argIdx], OPTION_CG) == 0) {
+                cgPreconditioner = CG_JACOBI;
+            } else if (strcmp(argv[argIdx], OPTION_CG_SSOR) == 0) {
+                cgPreconditioner = CG_SSOR;
+            } else {
                 std::cerr << "ERROR: Unexpected option '" << argv[argIdx] << "'!" << std::endl;
                 printUsage(argv[0]);
                 errorCode = 3;
             }
+        }
 
-            verbose = true;
-            ++argIdx;
+        if (errorCode != 0) {
+            return {numPointsPerDimension, verbose, errorCode};
         }
 
         numPointsPerDimension = std::strtol(argv[argIdx], nullptr, 10);
@@ -119,7 +143,7 @@ static InputOptions parseInput(int argc, char * argv[]) {
         }
     }
 
-    return {numPointsPerDimension, verbose, errorCode};
+    return {numPointsPerDimension, verbose, errorCode, false, multigridCycleIndex, cgPreconditioner};
 }
 
 std::tuple<int, double> performAlgorithm(double** points, double omega, double epsilon, int numPointsPerDimension) {
@@ -151,6 +175,30 @@ std::tuple<int, double> performAlgorithm(double** points, double omega, double e
     return std::make_tuple(numIterations, maxDiff);
 }
 
+/* Multigrid and conjugate gradients run on a single fragment holding the whole grid, without MPI. */
+static std::tuple<int, double> performOnGridFragment(double** points, InputOptions &inputOptions,
+                                                     double epsilon, int numPointsPerDimension) {
+    auto frag = new GridFragment(numPointsPerDimension, 1, 0);
+
+    for (int i = 0; i < numPointsPerDimension; ++i) {
+        for (int j = 0; j < numPointsPerDimension; ++j) {
+            GP(frag, i, j) = points[i][j];
+        }
+    }
+
+    auto result = inputOptions.getMultigridCycleIndex() != 0
+            ? runMultigrid(MPI_COMM_NULL, frag, inputOptions.getMultigridCycleIndex(), epsilon)
+            : runConjugateGradient(MPI_COMM_NULL, frag, inputOptions.getCgPreconditioner(), epsilon);
+
+    for (int i = 0; i < numPointsPerDimension; ++i) {
+        for (int j = 0; j < numPointsPerDimension; ++j) {
+            points[i][j] = GP(frag, i, j);
+        }
+    }
+
+    frag->free();
+    return result;
+}
 
 int main(int argc, char * argv[]) {
     struct timeval startTime {};
@@ -185,7 +233,9 @@ int main(int argc, char * argv[]) {
 
     /* Start of computations. */
 
-    auto result = performAlgorithm(pointsPointer, omega, epsilon, numPointsPerDimension);
+    auto result = inputOptions.getMultigridCycleIndex() != 0 || inputOptions.getCgPreconditioner() != 0
+            ? performOnGridFragment(pointsPointer, inputOptions, epsilon, numPointsPerDimension)
+            : performAlgorithm(pointsPointer, omega, epsilon, numPointsPerDimension);
 
     /* End of computations. */
 